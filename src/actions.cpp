@@ -15,9 +15,7 @@
 #include <set>
 #include <vector>
 #include <boost/algorithm/string/replace.hpp>
-#include <boost/filesystem/fstream.hpp>
 #include <boost/lexical_cast.hpp>
-#include <boost/next_prior.hpp>
 #include <boost/range/algorithm/replace.hpp>
 #include <boost/range/distance.hpp>
 #include "block_tags.hpp"
@@ -32,8 +30,11 @@
 #include "state.hpp"
 #include "state_save.hpp"
 #include "stream.hpp"
+#include "svg_size.hpp"
 #include "syntax_highlight.hpp"
+#include "template_library.hpp"
 #include "utils.hpp"
+#include "vfs.hpp"
 
 namespace quickbook
 {
@@ -156,7 +157,22 @@ namespace quickbook
     void element_action::operator()(parse_iterator first, parse_iterator) const
     {
         value_consumer values = state.values.release();
-        if (!values.check() || !state.conditional) return;
+        if (!values.check()) return;
+
+        // A precompiled library only has the definitions that were made when
+        // it was compiled, but a condition might be different when it's
+        // imported.
+        if (state.library && state.conditional_depth && !state.template_depth &&
+            (values.check(block_tags::macro_definition) ||
+             values.check(block_tags::template_definition))) {
+            detail::outerr(state.current_file, first.base())
+                << "Definitions in conditional phrases can't be precompiled."
+                << std::endl;
+            ++state.error_count;
+            return;
+        }
+
+        if (!state.conditional) return;
         value v = values.consume();
         values.finish();
 
@@ -304,7 +320,7 @@ namespace quickbook
         detail::markup markup = detail::get_markup(block.get_tag());
 
         value_consumer values = block;
-        state.out << markup.pre << values.consume().get_encoded()
+        state.out << markup.pre << values.consume().get_encoded_rope()
                   << markup.post;
         values.finish();
     }
@@ -324,7 +340,7 @@ namespace quickbook
         detail::markup markup = detail::get_markup(phrase.get_tag());
 
         value_consumer values = phrase;
-        state.phrase << markup.pre << values.consume().get_encoded()
+        state.phrase << markup.pre << values.consume().get_encoded_rope()
                      << markup.post;
         values.finish();
     }
@@ -341,7 +357,7 @@ namespace quickbook
         state.phrase << "<phrase role=\"";
         detail::print_string(
             get_attribute_value(state, role), state.phrase.get());
-        state.phrase << "\">" << phrase.get_encoded() << "</phrase>";
+        state.phrase << "\">" << phrase.get_encoded_rope() << "</phrase>";
     }
 
     void footnote_action(quickbook::state& state, value phrase)
@@ -351,7 +367,7 @@ namespace quickbook
         value_consumer values = phrase;
         state.phrase << "<footnote id=\""
                      << state.document.add_id("f", id_category::numbered)
-                     << "\"><para>" << values.consume().get_encoded()
+                     << "\"><para>" << values.consume().get_encoded_rope()
                      << "</para></footnote>";
         values.finish();
     }
@@ -525,7 +541,7 @@ namespace quickbook
         values.finish();
 
         state.phrase << markup.pre;
-        state.phrase << content.get_encoded();
+        state.phrase << content.get_encoded_rope();
         state.phrase << markup.post;
     }
 
@@ -534,6 +550,7 @@ namespace quickbook
         value_consumer values = state.values.release();
 
         saved_conditional = state.conditional;
+        ++state.conditional_depth;
 
         if (saved_conditional) {
             bool positive = values.consume().get_quickbook().empty();
@@ -560,6 +577,7 @@ namespace quickbook
         }
 
         state.conditional = saved_conditional;
+        --state.conditional_depth;
     }
 
     void state::start_list(char mark)
@@ -690,7 +708,7 @@ namespace quickbook
 
         QUICKBOOK_FOR (value item, list) {
             state.out << "<listitem>";
-            state.out << item.get_encoded();
+            state.out << item.get_encoded_rope();
             state.out << "</listitem>";
         }
 
@@ -833,8 +851,9 @@ namespace quickbook
     {
         write_anchors(state, state.phrase);
 
-        while (first != last)
-            detail::print_char(*first++, state.phrase.get());
+        detail::print_string(
+            quickbook::string_view(first.base(), last.base() - first.base()),
+            state.phrase.get());
     }
 
     void escape_unicode_action::operator()(
@@ -983,47 +1002,18 @@ namespace quickbook
                 img = quickbook::image_location / img; // relative path
 
             //
-            // Now load the SVG file:
+            // Now read the size from the SVG file's header:
             //
-            std::string svg_text;
             if (state.dependencies.add_dependency(img)) {
-                fs::ifstream fs(img);
-                std::stringstream buffer;
-                buffer << fs.rdbuf();
-                svg_text = buffer.str();
-            }
-
-            //
-            // Extract the svg header from the file:
-            //
-            std::string::size_type a, b;
-            a = svg_text.find("<svg");
-            b = svg_text.find('>', a);
-            svg_text =
-                (a == std::string::npos) ? "" : svg_text.substr(a, b - a);
-            //
-            // Now locate the "width" and "height" attributes
-            // and borrow their values:
-            //
-            a = svg_text.find("width");
-            a = svg_text.find('=', a);
-            a = svg_text.find('\"', a);
-            b = svg_text.find('\"', a + 1);
-            if (a != std::string::npos) {
-                attributes.insert(std::make_pair(
-                    "contentwidth", encoded_value(std::string(
-                                        boost::next(svg_text.begin(), a + 1),
-                                        boost::next(svg_text.begin(), b)))));
-            }
-            a = svg_text.find("height");
-            a = svg_text.find('=', a);
-            a = svg_text.find('\"', a);
-            b = svg_text.find('\"', a + 1);
-            if (a != std::string::npos) {
-                attributes.insert(std::make_pair(
-                    "contentdepth", encoded_value(std::string(
-                                        boost::next(svg_text.begin(), a + 1),
-                                        boost::next(svg_text.begin(), b)))));
+                svg_size size = read_svg_size(img);
+                if (size.has_width) {
+                    attributes.insert(std::make_pair(
+                        "contentwidth", encoded_value(size.width)));
+                }
+                if (size.has_height) {
+                    attributes.insert(std::make_pair(
+                        "contentdepth", encoded_value(size.height)));
+                }
             }
         }
 
@@ -1054,7 +1044,8 @@ namespace quickbook
         quickbook::state& state, quickbook::value macro_definition)
     {
         value_consumer values = macro_definition;
-        std::string macro_id = values.consume().get_quickbook().to_s();
+        value macro_id_value = values.consume();
+        std::string macro_id = macro_id_value.get_quickbook().to_s();
         value phrase_value = values.optional_consume();
         std::string phrase;
         if (phrase_value.check()) phrase = phrase_value.get_encoded();
@@ -1064,6 +1055,12 @@ namespace quickbook
             boost::spirit::classic::find(state.macro, macro_id.c_str());
         quickbook::ignore_variable(&existing_macro);
 
+        // Record the definition even if it's ignored, as it might not be
+        // when the library is imported.
+        if (state.library && !state.template_depth) {
+            state.library->add_macro(macro_id_value, phrase_value);
+        }
+
         if (existing_macro) {
             if (qbk_version_n < 106) return;
 
@@ -1093,6 +1090,10 @@ namespace quickbook
         value body = values.consume();
         BOOST_ASSERT(!values.check());
 
+        if (state.library && !state.template_depth) {
+            state.library->add_template(identifier, template_values, body);
+        }
+
         if (!state.templates.add(template_symbol(
                 identifier, template_values, body,
                 &state.templates.top_scope()))) {
@@ -1182,29 +1183,36 @@ namespace quickbook
             //                 (2 = template name + argument).
 
             if (qbk_version_n < 105 ? args.size() : args.size() == 1) {
-
-                while (args.size() < params.size()) {
-                    // Try to break the last argument at the first space found
-                    // and push it into the back of args. Do this
-                    // recursively until we have all the expected number of
-                    // arguments, or if there are no more spaces left.
-
-                    value last_arg = args.back();
-                    string_iterator begin = last_arg.get_quickbook().begin();
-                    string_iterator end = last_arg.get_quickbook().end();
-
-                    std::pair<string_iterator, string_iterator> pos =
-                        find_seperator(begin, end);
-                    if (pos.second == end) break;
-                    value new_arg(qbk_value(
-                        last_arg.get_file(), pos.second, end,
-                        template_tags::phrase));
-
-                    args.back() = qbk_value(
-                        last_arg.get_file(), begin, pos.first,
-                        last_arg.get_tag());
-                    args.push_back(new_arg);
-                }
+                if (args.size() >= params.size()) return;
+
+                // Split the last argument at each separator found until we
+                // have all the expected number of arguments, or there are no
+                // more spaces left. The pieces are only turned into values
+                // once their extent is known, so each one is only created
+                // once.
+
+                value last_arg = args.back();
+                file_ptr file = last_arg.get_file();
+                value::tag_type tag = last_arg.get_tag();
+                string_iterator begin = last_arg.get_quickbook().begin();
+                string_iterator end = last_arg.get_quickbook().end();
+
+                std::pair<string_iterator, string_iterator> pos =
+                    find_seperator(begin, end);
+                if (pos.second == end) return;
+
+                args.reserve(params.size());
+                args.pop_back();
+
+                do {
+                    args.push_back(qbk_value(file, begin, pos.first, tag));
+                    tag = template_tags::phrase;
+                    begin = pos.second;
+                } while (args.size() + 1 < params.size() &&
+                         (pos = find_seperator(begin, end)).second != end);
+
+                args.push_back(
+                    qbk_value(file, begin, end, template_tags::phrase));
             }
         }
 
@@ -1217,12 +1225,10 @@ namespace quickbook
         {
             std::vector<value>::const_iterator arg = args.begin();
             std::vector<std::string>::const_iterator tpl = params.begin();
-            std::vector<std::string> empty_params;
 
             // Store each of the argument passed in as local templates:
             while (arg != args.end()) {
-                if (!state.templates.add(
-                        template_symbol(*tpl, empty_params, *arg, &scope))) {
+                if (!state.templates.add_argument(*tpl, *arg, &scope)) {
                     detail::outerr(state.current_file, first)
                         << "Duplicate Symbol Found" << std::endl;
                     ++state.error_count;
@@ -1234,6 +1240,39 @@ namespace quickbook
             return std::make_pair(true, tpl);
         }
 
+        // Collects the block output of a pre-1.7 template, so that it can
+        // be added to the current output after the template has been
+        // expanded. A new stream is pushed, rather than swapping out the
+        // current output, as that might have been spilled to disk and
+        // would have to be read back in.
+        struct template_block_output
+        {
+            collector* out;
+
+            template_block_output() : out(0) {}
+            ~template_block_output()
+            {
+                if (out) out->pop();
+            }
+
+            void start(collector& out_)
+            {
+                out_.push();
+                out = &out_;
+            }
+
+            void finish(std::string& result)
+            {
+                out->swap(result);
+                out->pop();
+                out = 0;
+            }
+
+          private:
+            template_block_output(template_block_output const&);
+            template_block_output& operator=(template_block_output const&);
+        };
+
         bool parse_template(
             value const& content,
             quickbook::state& state,
@@ -1282,7 +1321,7 @@ namespace quickbook
 
         if (symbol->content.is_encoded()) {
             (is_block ? state.out : state.phrase)
-                << symbol->content.get_encoded();
+                << symbol->content.get_encoded_rope();
             return;
         }
 
@@ -1295,6 +1334,7 @@ namespace quickbook
 
         {
             state_save save(state, state_save::scope_callables);
+            template_block_output block_output;
             std::string save_block;
             std::string save_phrase;
 
@@ -1329,7 +1369,7 @@ namespace quickbook
             // parse the template body:
 
             if (symbol->content.get_file()->version() < 107u) {
-                state.out.swap(save_block);
+                block_output.start(state.out);
                 state.phrase.swap(save_phrase);
             }
 
@@ -1355,7 +1395,7 @@ namespace quickbook
             }
 
             if (symbol->content.get_file()->version() < 107u) {
-                state.out.swap(save_block);
+                block_output.finish(save_block);
                 state.phrase.swap(save_phrase);
 
                 if (is_block || !save_block.empty()) {
@@ -1428,7 +1468,7 @@ namespace quickbook
             }
 
             if (symbol->content.is_encoded()) {
-                state.phrase << symbol->content.get_encoded();
+                state.phrase << symbol->content.get_encoded_rope();
             }
             else {
                 state.phrase << symbol->content.get_quickbook();
@@ -1540,7 +1580,7 @@ namespace quickbook
         if (content.empty())
             detail::print_string(dst, state.phrase.get());
         else
-            state.phrase << content.get_encoded();
+            state.phrase << content.get_encoded_rope();
 
         state.phrase << markup.post;
     }
@@ -1564,14 +1604,14 @@ namespace quickbook
 
             if (entry.check()) {
                 state.out << "<term>";
-                state.out << entry.consume().get_encoded();
+                state.out << entry.consume().get_encoded_rope();
                 state.out << "</term>";
             }
 
             if (entry.check()) {
                 state.out << "<listitem>";
                 QUICKBOOK_FOR (value phrase, entry)
-                    state.out << phrase.get_encoded();
+                    state.out << phrase.get_encoded_rope();
                 state.out << "</listitem>";
             }
 
@@ -1635,7 +1675,7 @@ namespace quickbook
                 detail::print_string(title.get_quickbook(), state.out.get());
             }
             else {
-                state.out << title.get_encoded();
+                state.out << title.get_encoded_rope();
             }
             state.out << "</title>";
         }
@@ -1651,7 +1691,8 @@ namespace quickbook
             state.out << "<thead>"
                       << "<row>";
             QUICKBOOK_FOR (value cell, values.consume()) {
-                state.out << "<entry>" << cell.get_encoded() << "</entry>";
+                state.out << "<entry>" << cell.get_encoded_rope()
+                          << "</entry>";
             }
             state.out << "</row>\n"
                       << "</thead>\n";
@@ -1662,7 +1703,8 @@ namespace quickbook
         QUICKBOOK_FOR (value row, values) {
             state.out << "<row>";
             QUICKBOOK_FOR (value cell, row) {
-                state.out << "<entry>" << cell.get_encoded() << "</entry>";
+                state.out << "<entry>" << cell.get_encoded_rope()
+                          << "</entry>";
             }
             state.out << "</row>\n";
         }
@@ -1787,6 +1829,102 @@ namespace quickbook
         }
     }
 
+    namespace
+    {
+        // Import the templates and macros from the precompiled library for
+        // 'path' into the current scope, if there's one that's up to date.
+        // Returns false if the file should be parsed instead.
+        bool import_template_library(
+            quickbook::state& state, quickbook_path const& path)
+        {
+            // When precompiling, the definitions have to be recorded.
+            if (state.library) return false;
+
+            fs::path library_path = template_library_path(path.file_path);
+            if (!get_file_system().status(library_path).exists) return false;
+
+            template_library library;
+            try {
+                library.read(library_path);
+            } catch (template_library_error& e) {
+                detail::outwarn(library_path)
+                    << "Ignoring precompiled library: " << e.what()
+                    << std::endl;
+                return false;
+            }
+
+            // Check that it's up to date, and was compiled for this import.
+            if (!library.fixed_version &&
+                library.qbk_version != qbk_version_n) {
+                return false;
+            }
+            if (library.defines != preset_defines) return false;
+            if (!library.up_to_date(path.file_path->parent_path())) {
+                return false;
+            }
+
+            std::vector<file_ptr> files;
+            for (unsigned i = 0; i < library.sources.size(); ++i) {
+                state.dependencies.add_dependency(library.sources[i].path);
+                files.push_back(library.load_source(i));
+            }
+
+            {
+                // Like an import, this defines the templates and macros in
+                // the current scope.
+                state_save save(state, state_save::scope_output);
+                state.imported = true;
+
+                QUICKBOOK_FOR (
+                    template_library::definition const& d,
+                    library.definitions) {
+                    file_ptr const& f = files[d.source_index];
+                    string_iterator begin = f->source().begin();
+                    value body =
+                        qbk_value(f, begin + d.begin, begin + d.end, d.tag);
+
+                    if (d.type == template_library::definition::template_) {
+                        if (!state.templates.add(template_symbol(
+                                d.identifier, d.params, body,
+                                &state.templates.top_scope()))) {
+                            detail::outwarn(
+                                body.get_file(), body.get_position())
+                                << "Template Redefinition: " << d.identifier
+                                << std::endl;
+                            ++state.error_count;
+                        }
+                    }
+                    else {
+                        // Macros are parsed again, so that they use the
+                        // macros and templates from the importing document.
+                        template_library::source const& s =
+                            library.sources[d.source_index];
+                        qbk_version_n = f->version();
+                        state.current_path = quickbook_path(
+                            s.path, 0,
+                            s.abstract_path.has_root_directory()
+                                ? s.abstract_path
+                                : path.abstract_file_path->parent_path() /
+                                      s.abstract_path);
+                        state.update_filename_macro();
+
+                        if (!parse_template(body, state)) {
+                            detail::outerr(
+                                body.get_file(), body.get_position())
+                                << "Error importing macro: " << d.identifier
+                                << std::endl;
+                            ++state.error_count;
+                        }
+                    }
+                }
+            }
+
+            // restore the __FILENAME__ macro
+            state.update_filename_macro();
+            return true;
+        }
+    }
+
     void load_quickbook(
         quickbook::state& state,
         quickbook_path const& path,
@@ -1797,6 +1935,11 @@ namespace quickbook
             load_type == block_tags::include ||
             load_type == block_tags::import);
 
+        if (load_type == block_tags::import &&
+            import_template_library(state, path)) {
+            return;
+        }
+
         // Check this before qbk_version_n gets changed by the inner file.
         bool keep_inner_source_mode = (qbk_version_n < 106);
 
@@ -1818,6 +1961,10 @@ namespace quickbook
             state.current_file = load(path.file_path); // Throws load_error
             state.current_path = path;
             state.imported = (load_type == block_tags::import);
+            if (state.library) {
+                state.library->add_source(
+                    path.file_path, path.abstract_file_path);
+            }
 
             // update the __FILENAME__ macro
             state.update_filename_macro();
@@ -1844,7 +1991,14 @@ namespace quickbook
             load_type == block_tags::include ||
             load_type == block_tags::import);
 
-        std::string ext = path.file_path.extension().generic_string();
+        if (state.library) {
+            detail::outerr(state.current_file, first)
+                << "Code snippets can't be precompiled." << std::endl;
+            ++state.error_count;
+            return;
+        }
+
+        std::string ext = path.file_path->extension().generic_string();
         std::vector<template_symbol> storage;
         // Throws load_error
         state.error_count +=
@@ -1892,6 +2046,16 @@ namespace quickbook
         path_parameter parameter = check_path(values.consume(), state);
         values.finish();
 
+        // Included files aren't imported in 1.6+, but they are in older
+        // versions, and their templates aren't recorded.
+        if (state.library && include.get_tag() == block_tags::include &&
+            qbk_version_n < 106) {
+            detail::outerr(state.current_file, first)
+                << "Included files can't be precompiled." << std::endl;
+            ++state.error_count;
+            return;
+        }
+
         std::set<quickbook_path> search =
             include_search(parameter, state, first);
         QUICKBOOK_FOR (quickbook_path const& path, search) {
@@ -1902,7 +2066,7 @@ namespace quickbook
                         return;
 
                     std::string ext =
-                        path.file_path.extension().generic_string();
+                        path.file_path->extension().generic_string();
 
                     if (ext == ".qbk" || ext == ".quickbook") {
                         load_quickbook(
@@ -1947,9 +2111,9 @@ namespace quickbook
     void to_value_scoped_action::success(
         parse_iterator first, parse_iterator last)
     {
-        std::string value;
+        rope value;
 
-        if (!state.out.str().empty()) {
+        if (!state.out.empty()) {
             paragraph_action para(state);
             para(); // For paragraphs before the template call.
             write_anchors(state, state.out);
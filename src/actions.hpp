@@ -89,6 +89,10 @@ namespace quickbook
         std::string const& extension,
         value::tag_type load_type);
 
+    // Forget the snippets loaded by 'load_snippets', so that the files are
+    // parsed again when next used.
+    void clear_snippet_cache();
+
     struct error_message_action
     {
         // Prints an error message to std::cerr
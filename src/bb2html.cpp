@@ -7,11 +7,16 @@ http://www.boost.org/LICENSE_1_0.txt)
 =============================================================================*/
 
 #include "bb2html.hpp"
+#include <algorithm>
 #include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <boost/algorithm/string/predicate.hpp>
-#include <boost/filesystem/fstream.hpp>
-#include <boost/filesystem/operations.hpp>
+#include <boost/algorithm/string/trim.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/preprocessor/cat.hpp>
 #include <boost/preprocessor/stringize.hpp>
@@ -20,11 +25,13 @@ http://www.boost.org/LICENSE_1_0.txt)
 #include "boostbook_chunker.hpp"
 #include "files.hpp"
 #include "for.hpp"
+#include "gzip.hpp"
 #include "html_printer.hpp"
 #include "path.hpp"
-#include "post_process.hpp"
+#include "search_index.hpp"
 #include "stream.hpp"
 #include "utils.hpp"
+#include "vfs.hpp"
 #include "xml_parse.hpp"
 
 namespace quickbook
@@ -82,13 +89,18 @@ namespace quickbook
         void generate_docinfo_html(html_gen&, xml_element*);
         void generate_tree_html(html_gen&, xml_element*);
         void generate_children_html(html_gen&, xml_element*);
-        void write_file(
-            html_state&, std::string const& path, std::string const& content);
+        void write_file(html_state&, std::string const& path, html_printer&);
+        void write_output(
+            html_state&, std::string const& path, std::string&& content);
+        void add_to_search_index(html_gen&, chunk*);
+        void gather_text(std::string&, xml_element*);
         std::string get_link_from_path(
             html_gen&, quickbook::string_view, quickbook::string_view);
         std::string relative_path_or_url(html_gen&, path_or_url const&);
+        std::string relative_path_or_url(
+            html_gen&, path_or_url const&, quickbook::string_view);
         std::string relative_path_from_fs_paths(
-            fs::path const&, fs::path const&);
+            html_gen&, fs::path const&, quickbook::string_view);
         std::string relative_path_from_url_paths(
             quickbook::string_view, quickbook::string_view);
 
@@ -137,17 +149,164 @@ namespace quickbook
             }
         };
 
+#if defined(QUICKBOOK_GZIP)
+        // Writes gzip compressed copies of the pages on background
+        // threads, so that compression overlaps with generating the
+        // following pages. Errors can't be reported from the threads, so
+        // they're collected and returned by 'finish'. Only a few pages are
+        // queued at a time, 'add' waits for the threads to catch up, so
+        // that all the pages aren't held in memory.
+        struct gzip_writer
+        {
+            struct job
+            {
+                fs::path path;
+                std::string html;
+            };
+
+            bool skip_unchanged;
+            std::mutex mutex;
+            std::condition_variable queued;
+            std::condition_variable dequeued;
+            std::deque<job> queue;
+            std::vector<fs::path> failed;
+            std::vector<std::thread> threads;
+            unsigned max_threads;
+            bool stopping;
+
+            explicit gzip_writer(bool skip_unchanged_)
+                : skip_unchanged(skip_unchanged_)
+                , max_threads(std::min(4u, std::thread::hardware_concurrency()))
+                , stopping(false)
+            {
+                if (!max_threads) max_threads = 1;
+            }
+
+            ~gzip_writer() { finish(); }
+
+            void add(fs::path const& path, std::string&& html)
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                while (queue.size() >= max_threads * 2) {
+                    dequeued.wait(lock);
+                }
+                queue.push_back(job());
+                queue.back().path = path;
+                queue.back().html = std::move(html);
+                if (threads.size() < max_threads) {
+                    threads.push_back(std::thread(&gzip_writer::run, this));
+                }
+                lock.unlock();
+                queued.notify_one();
+            }
+
+            // Wait for the queued pages to be written, returns the paths
+            // which couldn't be written.
+            std::vector<fs::path> finish()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stopping = true;
+                }
+                queued.notify_all();
+                QUICKBOOK_FOR (std::thread& t, threads) {
+                    t.join();
+                }
+                threads.clear();
+
+                std::vector<fs::path> result;
+                result.swap(failed);
+                return result;
+            }
+
+            void run()
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                for (;;) {
+                    while (!stopping && queue.empty()) {
+                        queued.wait(lock);
+                    }
+                    if (queue.empty()) return;
+
+                    job j;
+                    j.path.swap(queue.front().path);
+                    j.html.swap(queue.front().html);
+                    queue.pop_front();
+                    lock.unlock();
+                    dequeued.notify_one();
+
+                    std::string compressed = gzip_compress(j.html);
+                    file_system& files = get_file_system();
+                    bool success =
+                        skip_unchanged
+                            ? update_file(
+                                  files, j.path, compressed,
+                                  file_system::binary_mode) != update_failed
+                            : files.write(
+                                  j.path, compressed, file_system::binary_mode);
+
+                    lock.lock();
+                    if (!success) failed.push_back(j.path);
+                }
+            }
+
+          private:
+            gzip_writer(gzip_writer const&);
+            gzip_writer& operator=(gzip_writer const&);
+        };
+#else
+        // Built without gzip support, so 'gzip_output' is ignored.
+        struct gzip_writer
+        {
+            explicit gzip_writer(bool) {}
+            void add(fs::path const&, std::string&&) {}
+            std::vector<fs::path> finish() { return std::vector<fs::path>(); }
+        };
+#endif
+
         struct html_state
         {
             ids_type const& ids;
             html_options const& options;
             unsigned int error_count;
+            // Set if compressed copies of the pages are being written.
+            gzip_writer* gzip;
+            // Set if a search index is being built.
+            search_index* search;
+
+            // Absolute paths for working out relative links. Only the home
+            // directory and the configured root paths are looked up in the
+            // filesystem, links are then worked out lexically.
+            split_path home_directory;
+            boost::unordered_map<fs::path, split_path> root_paths;
 
             explicit html_state(
                 ids_type const& ids_, html_options const& options_)
-                : ids(ids_), options(options_), error_count(0)
+                : ids(ids_)
+                , options(options_)
+                , error_count(0)
+                , gzip(0)
+                , search(0)
+                , home_directory(
+                      split_absolute_path(options.home_path.parent_path()))
+                , root_paths()
             {
             }
+
+            split_path const& root_path(fs::path const& path)
+            {
+                boost::unordered_map<fs::path, split_path>::iterator pos =
+                    root_paths.find(path);
+                if (pos == root_paths.end()) {
+                    pos = root_paths
+                              .emplace(
+                                  path,
+                                  split_absolute_path(path, home_directory))
+                              .first;
+                }
+                return pos->second;
+            }
         };
 
         struct callout_data
@@ -161,6 +320,7 @@ namespace quickbook
             std::vector<xml_element*> footnotes;
             boost::unordered_map<string_view, callout_data> callout_numbers;
             boost::unordered_set<string_view> fragment_ids;
+            split_path directory; // The directory containing the chunk
         };
 
         struct html_gen
@@ -207,9 +367,10 @@ namespace quickbook
         int boostbook_to_html(
             quickbook::string_view source, html_options const& options)
         {
+            xml_arena arena;
             xml_tree tree;
             try {
-                tree = xml_parse(source);
+                tree = xml_parse(arena, source);
             } catch (quickbook::detail::xml_parse_error e) {
                 string_view source_view(source);
                 file_position p = relative_position(source_view.begin(), e.pos);
@@ -246,8 +407,9 @@ namespace quickbook
                 // Create the root directory if necessary for chunked
                 // documentation.
                 fs::path parent = options.home_path.parent_path();
-                if (!parent.empty() && !fs::exists(parent)) {
-                    fs::create_directory(parent);
+                if (!options.output && !parent.empty() &&
+                    !get_file_system().status(parent).exists) {
+                    get_file_system().create_directories(parent);
                 }
             }
             else {
@@ -255,9 +417,29 @@ namespace quickbook
             }
             ids_type ids = get_id_paths(chunked.root());
             html_state state(ids, options);
+            std::unique_ptr<gzip_writer> gzip;
+            if (options.gzip_output && !options.output) {
+                gzip.reset(new gzip_writer(options.skip_unchanged));
+                state.gzip = gzip.get();
+            }
+            std::unique_ptr<search_index> search;
+            if (options.write_search_index) {
+                search.reset(new search_index());
+                state.search = search.get();
+            }
             if (chunked.root()) {
                 generate_chunks(state, chunked.root());
             }
+            if (search) {
+                write_output(state, "search-index.json", search->to_json());
+            }
+            if (gzip) {
+                QUICKBOOK_FOR (fs::path const& path, gzip->finish()) {
+                    ::quickbook::detail::outerr(path)
+                        << "Error writing to output file" << std::endl;
+                    ++state.error_count;
+                }
+            }
             return state.error_count;
         }
 
@@ -315,8 +497,16 @@ namespace quickbook
         {
             chunk_state c_state;
             gather_chunk_ids(c_state, x);
+            c_state.directory = state.home_directory;
+            c_state.directory.append(x->path_);
+            if (!c_state.directory.parts.empty()) {
+                c_state.directory.parts.pop_back();
+            }
             html_gen gen(state, c_state, x->path_);
-            gen.printer.html += "<!DOCTYPE html>\n";
+            if (state.options.pretty_print) {
+                start_pretty_print(gen.printer);
+            }
+            print_html(gen.printer, "<!DOCTYPE html>\n");
             open_tag(gen.printer, "html");
             open_tag(gen.printer, "head");
             if (state.options.css_path) {
@@ -339,7 +529,7 @@ namespace quickbook
             generate_footnotes_html(gen);
             close_tag(gen.printer, "body");
             close_tag(gen.printer, "html");
-            write_file(state, x->path_, gen.printer.html);
+            write_file(state, x->path_, gen.printer);
             for (; it; it = it->next()) {
                 assert(!it->inline_);
                 generate_chunks(state, it);
@@ -384,7 +574,7 @@ namespace quickbook
                     tag_end(gen.printer);
                     graphics_tag(gen, "/prev.png", "prev");
                     close_tag(gen.printer, "a");
-                    gen.printer.html += " ";
+                    print_html(gen.printer, " ");
                 }
                 if (x->parent()) {
                     tag_start(gen.printer, "a");
@@ -395,7 +585,7 @@ namespace quickbook
                     tag_end(gen.printer);
                     graphics_tag(gen, "/up.png", "up");
                     close_tag(gen.printer, "a");
-                    gen.printer.html += " ";
+                    print_html(gen.printer, " ");
 
                     tag_start(gen.printer, "a");
                     tag_attribute(
@@ -406,7 +596,7 @@ namespace quickbook
                     graphics_tag(gen, "/home.png", "home");
                     close_tag(gen.printer, "a");
                     if (next) {
-                        gen.printer.html += " ";
+                        print_html(gen.printer, " ");
                     }
                 }
                 if (next) {
@@ -444,12 +634,49 @@ namespace quickbook
             number_callouts(gen, x->info_.root());
             number_callouts(gen, x->contents_.root());
 
+            if (gen.state.search) {
+                add_to_search_index(gen, x);
+            }
+
             generate_tree_html(gen, x->title_.root());
             generate_docinfo_html(gen, x->info_.root());
             generate_toc_html(gen, x);
             generate_tree_html(gen, x->contents_.root());
         }
 
+        void add_to_search_index(html_gen& gen, chunk* x)
+        {
+            std::string path = x->path_;
+            if (x->inline_) {
+                path += '#';
+                path += x->id_;
+            }
+
+            std::string title;
+            gather_text(title, x->title_.root());
+            boost::algorithm::trim(title);
+            gen.state.search->add_document(path, title);
+            gen.state.search->add_text(title);
+
+            std::string text;
+            gather_text(text, x->contents_.root());
+            gen.state.search->add_text(text);
+        }
+
+        void gather_text(std::string& text, xml_element* x)
+        {
+            for (; x; x = x->next()) {
+                if (x->type_ == xml_element::element_text) {
+                    text += decode_string(x->contents_);
+                }
+                else if (x->type_ == xml_element::element_node) {
+                    gather_text(text, x->children());
+                    // Elements usually separate words.
+                    text += ' ';
+                }
+            }
+        }
+
         void generate_toc_html(html_gen& gen, chunk* x)
         {
             if (x->children() && x->contents_.root()->name_ != "section") {
@@ -458,7 +685,7 @@ namespace quickbook
                 tag_end(gen.printer);
                 open_tag(gen.printer, "p");
                 open_tag(gen.printer, "b");
-                gen.printer.html += "Table of contents";
+                print_html(gen.printer, "Table of contents");
                 close_tag(gen.printer, "b");
                 close_tag(gen.printer, "p");
                 generate_toc_subtree(gen, x, x, 1);
@@ -481,17 +708,19 @@ namespace quickbook
                 }
             }
 
-            gen.printer.html += "<ul>";
+            print_html(gen.printer, "<ul>");
             for (chunk* it = x->children(); it; it = it->next()) {
                 auto link = gen.state.ids.find(it->id_);
-                gen.printer.html += "<li>";
+                print_html(gen.printer, "<li>");
                 if (link != gen.state.ids.end()) {
-                    gen.printer.html += "<a href=\"";
-                    gen.printer.html += encode_string(get_link_from_path(
-                        gen, link->second.path(), page->path_));
-                    gen.printer.html += "\">";
+                    print_html(gen.printer, "<a href=\"");
+                    print_html(
+                        gen.printer, encode_string(get_link_from_path(
+                                         gen, link->second.path(),
+                                         page->path_)));
+                    print_html(gen.printer, "\">");
                     generate_toc_item_html(gen, it->title_.root());
-                    gen.printer.html += "</a>";
+                    print_html(gen.printer, "</a>");
                 }
                 else {
                     generate_toc_item_html(gen, it->title_.root());
@@ -504,9 +733,9 @@ namespace quickbook
                             ? section_depth - 1
                             : section_depth);
                 }
-                gen.printer.html += "</li>";
+                print_html(gen.printer, "</li>");
             }
-            gen.printer.html += "</ul>";
+            print_html(gen.printer, "</ul>");
         }
 
         void generate_toc_item_html(html_gen& gen, xml_element* x)
@@ -518,7 +747,7 @@ namespace quickbook
                 gen.in_toc = old;
             }
             else {
-                gen.printer.html += "<i>Untitled</i>";
+                print_html(gen.printer, "<i>Untitled</i>");
             }
         }
 
@@ -528,8 +757,8 @@ namespace quickbook
                 tag_start(gen.printer, "div");
                 tag_attribute(gen.printer, "class", "footnotes");
                 tag_end(gen.printer);
-                gen.printer.html += "<br/>";
-                gen.printer.html += "<hr/>";
+                print_html(gen.printer, "<br/>");
+                print_html(gen.printer, "<hr/>");
                 for (std::vector<xml_element*>::iterator it =
                          gen.chunk.footnotes.begin();
                      it != gen.chunk.footnotes.end(); ++it) {
@@ -596,11 +825,11 @@ namespace quickbook
             }
             switch (x->type_) {
             case xml_element::element_text: {
-                gen.printer.html += x->contents_;
+                print_html(gen.printer, x->contents_);
                 break;
             }
             case xml_element::element_html: {
-                gen.printer.html += x->contents_;
+                print_html(gen.printer, x->contents_);
                 break;
             }
             case xml_element::element_node: {
@@ -657,79 +886,89 @@ namespace quickbook
 
             if (!d.authors.empty() || !d.editors.empty() ||
                 !d.collabs.empty()) {
-                gen.printer.html += "<div class=\"authorgroup\">\n";
+                print_html(gen.printer, "<div class=\"authorgroup\">\n");
                 QUICKBOOK_FOR (auto const& author, d.authors) {
-                    gen.printer.html += "<h3 class=\"author\">";
-                    gen.printer.html += author;
-                    gen.printer.html += "</h3>\n";
+                    print_html(gen.printer, "<h3 class=\"author\">");
+                    print_html(gen.printer, author);
+                    print_html(gen.printer, "</h3>\n");
                 }
                 QUICKBOOK_FOR (auto const& editor, d.editors) {
-                    gen.printer.html += "<h3 class=\"editor\">";
-                    gen.printer.html += editor;
-                    gen.printer.html += "</h3>\n";
+                    print_html(gen.printer, "<h3 class=\"editor\">");
+                    print_html(gen.printer, editor);
+                    print_html(gen.printer, "</h3>\n");
                 }
                 QUICKBOOK_FOR (auto const& collab, d.collabs) {
-                    gen.printer.html += "<h3 class=\"collab\">";
-                    gen.printer.html += collab;
-                    gen.printer.html += "</h3>\n";
+                    print_html(gen.printer, "<h3 class=\"collab\">");
+                    print_html(gen.printer, collab);
+                    print_html(gen.printer, "</h3>\n");
                 }
-                gen.printer.html += "</div>\n";
+                print_html(gen.printer, "</div>\n");
             }
 
             QUICKBOOK_FOR (auto const& copyright, d.copyrights) {
-                gen.printer.html += "<p class=\"copyright\">";
-                gen.printer.html += copyright;
-                gen.printer.html += "</p>";
+                print_html(gen.printer, "<p class=\"copyright\">");
+                print_html(gen.printer, copyright);
+                print_html(gen.printer, "</p>");
             }
 
             QUICKBOOK_FOR (auto const& legalnotice, d.legalnotices) {
-                gen.printer.html += "<div class=\"legalnotice\">";
-                gen.printer.html += legalnotice;
-                gen.printer.html += "</div>";
+                print_html(gen.printer, "<div class=\"legalnotice\">");
+                print_html(gen.printer, legalnotice);
+                print_html(gen.printer, "</div>");
             }
         }
 
         void write_file(
             html_state& state,
             std::string const& generic_path,
-            std::string const& content)
+            html_printer& printer)
         {
-            fs::path path = state.options.home_path.parent_path() /
-                            generic_to_path(generic_path);
-            std::string html = content;
+            if (!end_pretty_print(printer)) {
+                ::quickbook::detail::outerr(
+                    state.options.home_path.parent_path() /
+                    generic_to_path(generic_path))
+                    << "Post Processing Failed." << std::endl;
+                ++state.error_count;
+            }
 
-            if (state.options.pretty_print) {
-                try {
-                    html = post_process(html, -1, -1, true);
-                } catch (quickbook::post_process_failure&) {
-                    ::quickbook::detail::outerr(path)
-                        << "Post Processing Failed." << std::endl;
-                    ++state.error_count;
-                }
+            write_output(state, generic_path, std::move(printer.html));
+        }
+
+        // Write a file to the output directory, or 'options.output'.
+        void write_output(
+            html_state& state,
+            std::string const& generic_path,
+            std::string&& html)
+        {
+            if (state.options.output) {
+                (*state.options.output)[generic_path] = std::move(html);
+                return;
             }
 
+            fs::path path = state.options.home_path.parent_path() /
+                            generic_to_path(generic_path);
+            file_system& files = get_file_system();
             fs::path parent = path.parent_path();
             if (state.options.chunked_output && !parent.empty() &&
-                !fs::exists(parent)) {
-                fs::create_directories(parent);
+                !files.status(parent).exists) {
+                files.create_directories(parent);
             }
 
-            fs::ofstream fileout(path);
+            bool success = state.options.skip_unchanged
+                               ? update_file(files, path, html) != update_failed
+                               : files.write(path, html);
 
-            if (fileout.fail()) {
+            if (!success) {
                 ::quickbook::detail::outerr(path)
-                    << "Error opening output file" << std::endl;
+                    << "Error writing to output file" << std::endl;
                 ++state.error_count;
                 return;
             }
 
-            fileout << html;
-
-            if (fileout.fail()) {
-                ::quickbook::detail::outerr(path)
-                    << "Error writing to output file" << std::endl;
-                ++state.error_count;
-                return;
+            if (state.gzip) {
+                fs::path gzip_path = path;
+                gzip_path += ".gz";
+                state.gzip->add(gzip_path, std::move(html));
             }
         }
 
@@ -753,9 +992,8 @@ namespace quickbook
                 }
                 else {
                     return relative_path_or_url(
-                        gen,
-                        gen.state.options.boost_root_path /
-                            string_view(it, link.end() - it));
+                        gen, gen.state.options.boost_root_path,
+                        string_view(it, link.end() - it));
                 }
             }
 
@@ -769,18 +1007,31 @@ namespace quickbook
                 return x.get_url();
             }
             else {
-                return relative_path_from_fs_paths(
-                    x.get_path(),
-                    gen.state.options.home_path.parent_path() /
-                        gen.path.to_s());
+                return relative_path_from_fs_paths(gen, x.get_path(), "");
             }
         }
 
-        // Note: assume that base is a file, not a directory.
+        std::string relative_path_or_url(
+            html_gen& gen, path_or_url const& x, quickbook::string_view path)
+        {
+            assert(x);
+            if (x.is_url()) {
+                return (x / path).get_url();
+            }
+            else {
+                return relative_path_from_fs_paths(gen, x.get_path(), path);
+            }
+        }
+
+        // The relative path from the current chunk to 'path' in 'root'.
+        // 'root' is looked up in the filesystem the first time it's used,
+        // after that this is purely lexical.
         std::string relative_path_from_fs_paths(
-            fs::path const& p, fs::path const& base)
+            html_gen& gen, fs::path const& root, quickbook::string_view path)
         {
-            return path_to_generic(path_difference(base.parent_path(), p));
+            split_path p = gen.state.root_path(root);
+            p.append(path);
+            return lexical_path_difference(gen.chunk.directory, p);
         }
 
         std::string relative_path_from_url_paths(
@@ -896,12 +1147,12 @@ namespace quickbook
                 tag_attribute(
                     gen.printer, "src",
                     relative_path_or_url(
-                        gen, gen.state.options.graphics_path / path));
+                        gen, gen.state.options.graphics_path, path));
                 tag_attribute(gen.printer, "alt", fallback);
                 tag_end(gen.printer);
             }
             else {
-                gen.printer.html.append(fallback.begin(), fallback.end());
+                print_html(gen.printer, fallback);
             }
         }
 
@@ -959,6 +1210,23 @@ namespace quickbook
         close_tag(gen.printer, BOOST_PP_STRINGIZE(html_name));                 \
     }
 
+// The chunker has already used the document element's title and info, so
+// only its contents are generated.
+#define NODE_DOCUMENT(tag_name)                                                \
+    NODE_RULE(tag_name, gen, x) { generate_children_html(gen, x); }
+
+        NODE_DOCUMENT(book)
+        NODE_DOCUMENT(article)
+        NODE_DOCUMENT(library)
+        NODE_DOCUMENT(chapter)
+        NODE_DOCUMENT(part)
+        NODE_DOCUMENT(appendix)
+        NODE_DOCUMENT(preface)
+        NODE_DOCUMENT(qandadiv)
+        NODE_DOCUMENT(qandaset)
+        NODE_DOCUMENT(reference)
+        NODE_DOCUMENT(set)
+
         // TODO: For some reason 'hr' generates an empty paragraph?
         NODE_MAP(simpara, div)
         NODE_MAP(orderedlist, ol)
@@ -1337,7 +1605,7 @@ namespace quickbook
             if (link != gen.state.ids.end()) {
                 close_tag(gen.printer, "a");
             }
-            gen.printer.html += " ";
+            print_html(gen.printer, " ");
             generate_children_html(gen, x);
             close_tag(gen.printer, "div");
         }
@@ -1371,7 +1639,7 @@ namespace quickbook
                         ")");
             }
             else {
-                gen.printer.html += "(0)";
+                print_html(gen.printer, "(0)");
             }
             if (link != gen.state.ids.end()) {
                 close_tag(gen.printer, "a");
@@ -1399,7 +1667,7 @@ namespace quickbook
             tag_start(gen.printer, "sup");
             tag_attribute(gen.printer, "class", "footnote");
             tag_end(gen.printer);
-            gen.printer.html += "[" + footnote_label + "]";
+            print_html(gen.printer, "[" + footnote_label + "]");
             close_tag(gen.printer, "sup");
             close_tag(gen.printer, "a");
 
@@ -1412,12 +1680,13 @@ namespace quickbook
             tag_end(printer);
             tag_start(printer, "sup");
             tag_end(printer);
-            printer.html += "[" + footnote_label + "]";
+            print_html(printer, "[" + footnote_label + "]");
             close_tag(printer, "sup");
             close_tag(printer, "a");
-            printer.html += ' ';
+            print_html(printer, " ");
             xml_tree_builder builder;
-            builder.add_element(xml_element::html_node(printer.html));
+            builder.add_element(
+                xml_element::html_node(x->arena(), printer.html));
 
             // Find position to insert.
             auto pos = x->children();
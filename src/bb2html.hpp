@@ -9,6 +9,7 @@
 #if !defined(BOOST_QUICKBOOK_BOOSTBOOK_TO_HTML_HPP)
 #define BOOST_QUICKBOOK_BOOSTBOOK_TO_HTML_HPP
 
+#include <map>
 #include <string>
 #include "path.hpp"
 #include "string_view.hpp"
@@ -25,8 +26,28 @@ namespace quickbook
             path_or_url css_path;
             path_or_url graphics_path;
             bool pretty_print;
+            // If set, the pages are stored here instead of being written to
+            // disk, keyed by their generic path relative to the directory
+            // of 'home_path'.
+            std::map<std::string, std::string>* output;
+            // Leave pages that haven't changed alone, see 'update_file'.
+            bool skip_unchanged;
+            // Also write a gzip compressed copy of each page, with '.gz'
+            // appended to its filename. Ignored unless quickbook is built
+            // with 'quickbook-gzip=on'.
+            bool gzip_output;
+            // Write 'search-index.json' alongside the home page, see
+            // 'search_index.hpp' for the format.
+            bool write_search_index;
 
-            html_options() : chunked_output(false) {}
+            html_options()
+                : chunked_output(false)
+                , output(0)
+                , skip_unchanged(false)
+                , gzip_output(false)
+                , write_search_index(false)
+            {
+            }
         };
 
         int boostbook_to_html(quickbook::string_view, html_options const&);
@@ -9,39 +9,34 @@ http://www.boost.org/LICENSE_1_0.txt)
 #include "boostbook_chunker.hpp"
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/lexical_cast.hpp>
-#include <boost/unordered_set.hpp>
+#include "string_table.hpp"
 
 namespace quickbook
 {
     namespace detail
     {
-        boost::unordered_set<std::string> chunk_types;
-        boost::unordered_set<std::string> chunkinfo_types;
-
-        static struct init_chunk_type
+        namespace
         {
-            init_chunk_type()
-            {
-                chunk_types.insert("book");
-                chunk_types.insert("article");
-                chunk_types.insert("library");
-                chunk_types.insert("chapter");
-                chunk_types.insert("part");
-                chunk_types.insert("appendix");
-                chunk_types.insert("preface");
-                chunk_types.insert("qandadiv");
-                chunk_types.insert("qandaset");
-                chunk_types.insert("reference");
-                chunk_types.insert("set");
-                chunk_types.insert("section");
-
-                for (boost::unordered_set<std::string>::const_iterator it =
-                         chunk_types.begin();
-                     it != chunk_types.end(); ++it) {
-                    chunkinfo_types.insert(*it + "info");
-                }
-            }
-        } init_chunk;
+            // Sorted, see string_table.hpp.
+            constexpr static_string chunk_types_[] = {
+                "appendix", "article", "book",     "chapter",  "library",
+                "part",     "preface", "qandadiv", "qandaset", "reference",
+                "section",  "set"};
+
+            constexpr static_string chunkinfo_types_[] = {
+                "appendixinfo", "articleinfo",   "bookinfo",    "chapterinfo",
+                "libraryinfo",  "partinfo",      "prefaceinfo", "qandadivinfo",
+                "qandasetinfo", "referenceinfo", "sectioninfo", "setinfo"};
+
+            static_assert(
+                is_sorted_table(chunk_types_), "chunk_types_ isn't sorted");
+            static_assert(
+                is_sorted_table(chunkinfo_types_),
+                "chunkinfo_types_ isn't sorted");
+
+            constexpr string_table chunk_types(chunk_types_);
+            constexpr string_table chunkinfo_types(chunkinfo_types_);
+        }
 
         struct chunk_builder : tree_builder<chunk>
         {
@@ -123,12 +118,12 @@ namespace quickbook
             }
             else if (
                 parent && node->type_ == xml_element::element_node &&
-                chunkinfo_types.find(node->name_) != chunkinfo_types.end()) {
+                chunkinfo_types.contains(node->name_)) {
                 parent->info_ = tree.extract(node);
             }
             else if (
                 node->type_ == xml_element::element_node &&
-                chunk_types.find(node->name_) != chunk_types.end()) {
+                chunk_types.contains(node->name_)) {
                 chunk* chunk_node = new chunk(tree.extract(node));
                 builder.add_element(chunk_node);
 
@@ -7,11 +7,15 @@
     http://www.boost.org/LICENSE_1_0.txt)
 =============================================================================*/
 
+#include <cstring>
+#include <utility>
 #include <boost/bind/bind.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/spirit/include/classic_actor.hpp>
 #include <boost/spirit/include/classic_confix.hpp>
 #include <boost/spirit/include/classic_core.hpp>
+#include <boost/unordered_map.hpp>
 #include "actions.hpp"
 #include "block_tags.hpp"
 #include "files.hpp"
@@ -96,6 +100,54 @@ namespace quickbook
         int error_count;
     };
 
+    // Skips over code which can't contain any snippet markup, so that the
+    // snippet rules are only tried where they might match. Always consumes at
+    // least one character, and then stops at the next character from
+    // 'markers', or at the whitespace preceding it, as the rules can start by
+    // skipping whitespace. Every marker begins with one of those characters,
+    // so the rules can't match anywhere that's skipped.
+    struct skip_code_parser : cl::parser<skip_code_parser>
+    {
+        explicit skip_code_parser(char const* markers_) : markers(markers_) {}
+
+        template <typename ScannerT> struct result
+        {
+            typedef cl::match<> type;
+        };
+
+        template <typename ScannerT>
+        typename result<ScannerT>::type parse(ScannerT const& scan) const
+        {
+            if (scan.at_end()) return scan.no_match();
+
+            string_iterator first = scan.first;
+            string_iterator last = scan.last;
+            string_iterator next = last;
+
+            for (char const* m = markers; *m; ++m) {
+                void const* pos = std::memchr(first + 1, *m, next - first - 1);
+                if (pos) next = static_cast<string_iterator>(pos);
+            }
+
+            if (next != last) {
+                while (next - 1 != first && is_space(next[-1])) {
+                    --next;
+                }
+            }
+
+            scan.first = next;
+            return scan.create_match(next - first, cl::nil_t(), first, next);
+        }
+
+        static bool is_space(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
+                   c == '\f' || c == '\v';
+        }
+
+        char const* markers;
+    };
+
     struct python_code_snippet_grammar
         : cl::grammar<python_code_snippet_grammar>
     {
@@ -126,7 +178,7 @@ namespace quickbook
                     |   escaped_comment             [boost::bind(&actions_type::escaped_comment, &self.actions, _1, _2)]
                     |   pass_thru_comment           [boost::bind(&actions_type::pass_thru, &self.actions, _1, _2)]
                     |   ignore                      [boost::bind(&actions_type::append_code, &self.actions, _1, _2)]
-                    |   cl::anychar_p
+                    |   skip_code_parser("#\"")
                     ;
 
                 start_snippet =
@@ -227,7 +279,7 @@ namespace quickbook
                     |   escaped_comment             [boost::bind(&actions_type::escaped_comment, &self.actions, _1, _2)]
                     |   ignore                      [boost::bind(&actions_type::append_code, &self.actions, _1, _2)]
                     |   pass_thru_comment           [boost::bind(&actions_type::pass_thru, &self.actions, _1, _2)]
-                    |   cl::anychar_p
+                    |   skip_code_parser("/")
                     ;
 
                 start_snippet =
@@ -331,6 +383,29 @@ namespace quickbook
         actions_type& actions;
     };
 
+    namespace
+    {
+        // The snippets found in a file, so that a file that's imported
+        // several times is only parsed once. The templates' lexical parents
+        // are set when they're added to the template stack, so the snippets
+        // don't depend on where they're loaded from, only on the file and the
+        // quickbook version.
+        struct snippet_cache_entry
+        {
+            std::vector<template_symbol> snippets;
+        };
+
+        typedef std::pair<fs::path, unsigned> snippet_cache_key;
+
+        boost::unordered_map<snippet_cache_key, snippet_cache_entry>
+            snippet_cache;
+
+        int parse_snippets(
+            fs::path const& filename,
+            std::vector<template_symbol>& storage,
+            std::string const& extension);
+    }
+
     int load_snippets(
         fs::path const& filename,
         std::vector<template_symbol>& storage // snippets are stored in a
@@ -344,27 +419,59 @@ namespace quickbook
             load_type == block_tags::include ||
             load_type == block_tags::import);
 
-        bool is_python = extension == ".py" || extension == ".jam";
-        code_snippet_actions a(
-            storage, load(filename, qbk_version_n),
-            is_python ? "[python]" : "[c++]");
+        snippet_cache_key key(filename, qbk_version_n);
+        boost::unordered_map<snippet_cache_key, snippet_cache_entry>::iterator
+            pos = snippet_cache.find(key);
 
-        string_iterator first(a.source_file->source().begin());
-        string_iterator last(a.source_file->source().end());
+        // Errors are only reported when the file is parsed, so they're only
+        // counted then as well.
+        int error_count = 0;
 
-        cl::parse_info<string_iterator> info;
-
-        if (is_python) {
-            info = boost::spirit::classic::parse(
-                first, last, python_code_snippet_grammar(a));
-        }
-        else {
-            info = boost::spirit::classic::parse(
-                first, last, cpp_code_snippet_grammar(a));
+        if (pos == snippet_cache.end()) {
+            // Throws load_error, in which case nothing is cached, so the
+            // error is reported again if the file is loaded again.
+            snippet_cache_entry entry;
+            error_count = parse_snippets(filename, entry.snippets, extension);
+            pos = snippet_cache.emplace(key, entry).first;
         }
 
-        assert(info.full);
-        return a.error_count;
+        storage.insert(
+            storage.end(), pos->second.snippets.begin(),
+            pos->second.snippets.end());
+        return error_count;
+    }
+
+    void clear_snippet_cache() { snippet_cache.clear(); }
+
+    namespace
+    {
+        int parse_snippets(
+            fs::path const& filename,
+            std::vector<template_symbol>& storage,
+            std::string const& extension)
+        {
+            bool is_python = extension == ".py" || extension == ".jam";
+            code_snippet_actions a(
+                storage, load(filename, qbk_version_n),
+                is_python ? "[python]" : "[c++]");
+
+            string_iterator first(a.source_file->source().begin());
+            string_iterator last(a.source_file->source().end());
+
+            cl::parse_info<string_iterator> info;
+
+            if (is_python) {
+                info = boost::spirit::classic::parse(
+                    first, last, python_code_snippet_grammar(a));
+            }
+            else {
+                info = boost::spirit::classic::parse(
+                    first, last, cpp_code_snippet_grammar(a));
+            }
+
+            assert(info.full);
+            return a.error_count;
+        }
     }
 
     void code_snippet_actions::append_code(
@@ -7,29 +7,156 @@
     http://www.boost.org/LICENSE_1_0.txt)
 =============================================================================*/
 #include "collector.hpp"
+#include <utility>
 #include <boost/assert.hpp>
+#include "spill_file.hpp"
 
 namespace quickbook
 {
+    namespace
+    {
+        // Smaller chunks are copied rather than shared, as it's cheaper
+        // than keeping track of them.
+        std::size_t const min_shared_chunk = 256;
+    }
+
     string_stream::string_stream()
         : buffer_ptr(new std::string())
+        , chunks_ptr(new rope())
         , stream_ptr(
               new ostream(boost::iostreams::back_inserter(*buffer_ptr.get())))
+        , spill_ptr(0)
+        , spill_threshold(0)
     {
     }
 
     string_stream::string_stream(string_stream const& other)
-        : buffer_ptr(other.buffer_ptr), stream_ptr(other.stream_ptr)
+        : buffer_ptr(other.buffer_ptr)
+        , chunks_ptr(other.chunks_ptr)
+        , stream_ptr(other.stream_ptr)
+        , spill_ptr(other.spill_ptr)
+        , spill_threshold(other.spill_threshold)
     {
     }
 
     string_stream& string_stream::operator=(string_stream const& other)
     {
         buffer_ptr = other.buffer_ptr;
+        chunks_ptr = other.chunks_ptr;
         stream_ptr = other.stream_ptr;
+        spill_ptr = other.spill_ptr;
+        spill_threshold = other.spill_threshold;
         return *this;
     }
 
+    bool string_stream::empty() const
+    {
+        stream_ptr->flush();
+        return chunks_ptr->empty() && buffer_ptr->empty() &&
+               (!spill_ptr || spill_ptr->empty());
+    }
+
+    void string_stream::clear()
+    {
+        stream_ptr->flush();
+        chunks_ptr->clear();
+        buffer_ptr->clear();
+        if (spill_ptr) spill_ptr->clear();
+    }
+
+    std::string const& string_stream::str() const
+    {
+        stream_ptr->flush();
+        unspill();
+        if (!chunks_ptr->empty()) {
+            std::string joined;
+            joined.reserve(chunks_ptr->size() + buffer_ptr->size());
+            chunks_ptr->write(joined);
+            joined += *buffer_ptr;
+            buffer_ptr->swap(joined);
+            chunks_ptr->clear();
+        }
+        return *buffer_ptr.get();
+    }
+
+    void string_stream::swap(rope& other)
+    {
+        stream_ptr->flush();
+        unspill();
+        flush_buffer();
+        chunks_ptr->swap(other);
+    }
+
+    void string_stream::append(rope const& other)
+    {
+        stream_ptr->flush();
+        for (rope::iterator it = other.begin(); it != other.end(); ++it) {
+            if ((*it)->size() < min_shared_chunk) {
+                *buffer_ptr += **it;
+            }
+            else {
+                flush_buffer();
+                chunks_ptr->append(*it);
+            }
+        }
+        if (spill_ptr) spill_if_full();
+    }
+
+    // Move the buffer's contents to the end of the chunks.
+    void string_stream::flush_buffer() const
+    {
+        if (!buffer_ptr->empty()) {
+            chunks_ptr->append(std::move(*buffer_ptr));
+            buffer_ptr->clear();
+        }
+    }
+
+    void string_stream::spill_to(spill_file* file, std::size_t threshold)
+    {
+        BOOST_ASSERT(!spill_ptr || spill_ptr->empty());
+        spill_ptr = file;
+        spill_threshold = threshold;
+    }
+
+    void string_stream::spill()
+    {
+        BOOST_ASSERT(spill_ptr);
+        stream_ptr->flush();
+        for (rope::iterator it = chunks_ptr->begin(); it != chunks_ptr->end();
+             ++it) {
+            spill_ptr->write(**it);
+        }
+        chunks_ptr->clear();
+        spill_ptr->write(*buffer_ptr);
+        buffer_ptr->clear();
+    }
+
+    void string_stream::spill_if_full()
+    {
+        if (chunks_ptr->size() + buffer_ptr->size() > spill_threshold) {
+            spill();
+        }
+    }
+
+    // Move any spilled output back into memory, in front of the chunks.
+    void string_stream::unspill() const
+    {
+        if (!spill_ptr || spill_ptr->empty()) return;
+
+        std::string spilled, block;
+        spilled.reserve(static_cast<std::size_t>(spill_ptr->size()));
+        spill_ptr->rewind();
+        while (spill_ptr->read(block)) {
+            spilled += block;
+        }
+        spill_ptr->clear();
+
+        rope joined;
+        joined.append(std::move(spilled));
+        joined.append(*chunks_ptr);
+        chunks_ptr->swap(joined);
+    }
+
     collector::collector() : main(default_), top(default_) {}
 
     collector::collector(string_stream& out) : main(out), top(out) {}
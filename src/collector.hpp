@@ -16,9 +16,18 @@
 #include <boost/noncopyable.hpp>
 #include <boost/ref.hpp>
 #include <boost/shared_ptr.hpp>
+#include "rope.hpp"
 
 namespace quickbook
 {
+    class spill_file;
+
+    // The output is kept in 'buffer_ptr', apart from any ropes which have
+    // been appended, which are kept in 'chunks_ptr', in front of the
+    // buffer, until a single string is needed.
+    //
+    // If 'spill_to' has been called, output can also be moved to a file,
+    // in front of both of them.
     struct string_stream
     {
         typedef boost::iostreams::filtering_ostream ostream;
@@ -27,31 +36,48 @@ namespace quickbook
         string_stream(string_stream const& other);
         string_stream& operator=(string_stream const& other);
 
-        std::string const& str() const
-        {
-            stream_ptr->flush();
-            return *buffer_ptr.get();
-        }
+        std::string const& str() const;
 
         std::ostream& get() const { return *stream_ptr.get(); }
 
-        void clear() { buffer_ptr->clear(); }
+        bool empty() const;
+        void clear();
 
         void swap(std::string& other)
         {
-            stream_ptr->flush();
+            str();
             std::swap(other, *buffer_ptr.get());
         }
 
+        void swap(rope& other);
+
         void append(std::string const& other)
         {
             stream_ptr->flush();
             *buffer_ptr.get() += other;
+            if (spill_ptr) spill_if_full();
         }
 
+        void append(rope const& other);
+
+        // Move the output to 'file' whenever more than 'threshold' bytes
+        // are held in memory. Only checked when strings or ropes are
+        // appended, which is how most block level output is written. Any
+        // call which needs the output as a string reads it back in.
+        void spill_to(spill_file* file, std::size_t threshold);
+        // Move everything that's held in memory to the spill file.
+        void spill();
+
       private:
+        void flush_buffer() const;
+        void spill_if_full();
+        void unspill() const;
+
         boost::shared_ptr<std::string> buffer_ptr;
+        boost::shared_ptr<rope> chunks_ptr;
         boost::shared_ptr<ostream> stream_ptr;
+        spill_file* spill_ptr;
+        std::size_t spill_threshold;
     };
 
     struct collector : boost::noncopyable
@@ -67,12 +93,18 @@ namespace quickbook
 
         std::string const& str() const { return top.get().str(); }
 
+        bool empty() const { return top.get().empty(); }
+
         void clear() { top.get().clear(); }
 
         void swap(std::string& other) { top.get().swap(other); }
 
+        void swap(rope& other) { top.get().swap(other); }
+
         void append(std::string const& other) { top.get().append(other); }
 
+        void append(rope const& other) { top.get().append(other); }
+
       private:
         std::stack<string_stream> streams;
         string_stream default_;
@@ -92,6 +124,12 @@ namespace quickbook
         out.append(val);
         return out;
     }
+
+    inline collector& operator<<(collector& out, rope const& val)
+    {
+        out.append(val);
+        return out;
+    }
 }
 
 #endif // BOOST_SPIRIT_QUICKBOOK_COLLECTOR_HPP
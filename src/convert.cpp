@@ -0,0 +1,299 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#include "convert.hpp"
+#include <ctime>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include "actions.hpp"
+#include "bb2html.hpp"
+#include "document_state.hpp"
+#include "files.hpp"
+#include "grammar.hpp"
+#include "include_paths.hpp"
+#include "post_process.hpp"
+#include "quickbook.hpp"
+#include "state.hpp"
+#include "svg_size.hpp"
+
+namespace quickbook
+{
+    convert_options::convert_options()
+        : format(boostbook)
+        , chunked_output(false)
+        , pretty_print(true)
+        , indent(-1)
+        , linewidth(-1)
+        , strict_mode(false)
+        , self_linked_headers(true)
+        , fixed_date(false)
+        , include_path()
+        , defines()
+        , image_location()
+        , xinclude_base()
+        , home_path()
+        , boost_root_path()
+        , css_path()
+        , graphics_path()
+        , files(0)
+    {
+    }
+
+    convert_result::convert_result()
+        : success(false), boostbook(), html(), diagnostics(), dependencies()
+    {
+    }
+
+    namespace
+    {
+        std::mutex convert_mutex;
+
+        struct file_system_scope
+        {
+            file_system* previous;
+
+            explicit file_system_scope(file_system* f)
+                : previous(set_file_system(f))
+            {
+            }
+
+            ~file_system_scope() { set_file_system(previous); }
+
+          private:
+            file_system_scope(file_system_scope const&);
+            file_system_scope& operator=(file_system_scope const&);
+        };
+
+        // Sets the global settings for a conversion, and restores the
+        // previous settings afterwards.
+        struct global_settings
+        {
+            tm* current_time;
+            tm* current_gm_time;
+            bool debug_mode;
+            bool self_linked_headers;
+            std::vector<fs::path> include_path;
+            std::vector<std::string> preset_defines;
+            fs::path image_location;
+            file_system_scope files;
+            tm local_time;
+            tm gm_time;
+
+            global_settings(
+                fs::path const& path, convert_options const& options)
+                : current_time(quickbook::current_time)
+                , current_gm_time(quickbook::current_gm_time)
+                , debug_mode(quickbook::debug_mode)
+                , self_linked_headers(quickbook::self_linked_headers)
+                , include_path(options.include_path)
+                , preset_defines(options.defines)
+                , image_location(
+                      options.image_location.empty()
+                          ? path.parent_path() / "html"
+                          : options.image_location)
+                , files(options.files)
+            {
+                if (options.fixed_date) {
+                    local_time = tm();
+                    local_time.tm_year = 2000 - 1900;
+                    local_time.tm_mon = 12 - 1;
+                    local_time.tm_mday = 20;
+                    local_time.tm_hour = 12;
+                    local_time.tm_isdst = -1;
+                    mktime(&local_time);
+                    gm_time = local_time;
+                }
+                else {
+                    time_t t = std::time(0);
+                    local_time = *localtime(&t);
+                    gm_time = *gmtime(&t);
+                }
+
+                quickbook::current_time = &local_time;
+                quickbook::current_gm_time = &gm_time;
+                quickbook::debug_mode = options.fixed_date;
+                quickbook::self_linked_headers =
+                    options.self_linked_headers &&
+                    options.format != convert_options::html;
+                swap_paths();
+            }
+
+            ~global_settings()
+            {
+                quickbook::current_time = current_time;
+                quickbook::current_gm_time = current_gm_time;
+                quickbook::debug_mode = debug_mode;
+                quickbook::self_linked_headers = self_linked_headers;
+                swap_paths();
+            }
+
+            void swap_paths()
+            {
+                quickbook::include_path.swap(include_path);
+                quickbook::preset_defines.swap(preset_defines);
+                quickbook::image_location.swap(image_location);
+            }
+
+          private:
+            global_settings(global_settings const&);
+            global_settings& operator=(global_settings const&);
+        };
+
+        // Parse the document, returns false on error.
+        bool parse_document(
+            fs::path const& path,
+            quickbook::string_view source,
+            convert_options const& options,
+            std::string& boostbook,
+            std::string& dependencies)
+        {
+            string_stream buffer;
+            document_state output;
+            bool success = false;
+
+            try {
+                quickbook::state state(
+                    path,
+                    options.xinclude_base.empty() ? path.parent_path()
+                                                  : options.xinclude_base,
+                    buffer, output);
+                state.strict_mode = options.strict_mode;
+                set_macros(state);
+
+                if (state.error_count == 0) {
+                    state.dependencies.add_dependency(path);
+                    state.current_file = add_file(path, source);
+                    parse_file(state);
+                }
+
+                std::ostringstream deps;
+                state.dependencies.write_dependencies(deps);
+                dependencies = deps.str();
+
+                success = !state.error_count;
+            } catch (load_error& e) {
+                detail::outerr(path) << e.what() << std::endl;
+            } catch (std::runtime_error& e) {
+                detail::outerr() << e.what() << std::endl;
+            }
+
+            if (success) {
+                boostbook = output.replace_placeholders(buffer.str());
+            }
+
+            return success;
+        }
+    }
+
+    convert_result convert(
+        fs::path const& path,
+        quickbook::string_view source,
+        convert_options const& options)
+    {
+        std::lock_guard<std::mutex> lock(convert_mutex);
+        global_settings settings(path, options);
+        detail::diagnostic_capture capture;
+        convert_result result;
+
+        // Files, snippets, directory listings and svg sizes are cached by
+        // path alone, so they would return stale contents from a previous
+        // conversion, or from a different file system. The prefetcher is
+        // also reset at the end, so that its threads don't use the caller's
+        // file system after returning.
+        reset_prefetch();
+        clear_loaded_files();
+        clear_snippet_cache();
+        clear_directory_cache();
+        clear_svg_size_cache();
+        clear_interned_paths();
+
+        result.success = parse_document(
+            path, source, options, result.boostbook, result.dependencies);
+
+        if (result.success && options.pretty_print) {
+            try {
+                result.boostbook = post_process(
+                    result.boostbook, options.indent, options.linewidth);
+            } catch (quickbook::post_process_failure&) {
+                detail::outerr() << "Post Processing Failed." << std::endl;
+                result.success = false;
+            }
+        }
+
+        if (result.success && options.format == convert_options::html) {
+            detail::html_options html_ops;
+            html_ops.chunked_output = options.chunked_output;
+            html_ops.pretty_print = options.pretty_print;
+            html_ops.output = &result.html;
+            html_ops.home_path = options.home_path;
+            if (html_ops.home_path.empty()) {
+                if (options.chunked_output) {
+                    html_ops.home_path =
+                        path.parent_path() / "html" / "index.html";
+                }
+                else {
+                    html_ops.home_path = path;
+                    html_ops.home_path.replace_extension(".html");
+                }
+            }
+
+            html_ops.boost_root_path = options.boost_root_path;
+            html_ops.css_path = options.css_path;
+            if (!html_ops.css_path && html_ops.boost_root_path) {
+                html_ops.css_path =
+                    html_ops.boost_root_path / "doc/src/boostbook.css";
+            }
+            html_ops.graphics_path = options.graphics_path;
+            if (!html_ops.graphics_path && html_ops.boost_root_path) {
+                html_ops.graphics_path =
+                    html_ops.boost_root_path / "doc/src/images";
+            }
+
+            result.success =
+                !detail::boostbook_to_html(result.boostbook, html_ops);
+        }
+
+        reset_prefetch();
+        clear_loaded_files();
+        clear_snippet_cache();
+        clear_directory_cache();
+        clear_svg_size_cache();
+        clear_interned_paths();
+        result.diagnostics = capture.diagnostics();
+        return result;
+    }
+
+    convert_result convert_file(
+        fs::path const& path, convert_options const& options)
+    {
+        std::string source;
+
+        {
+            std::lock_guard<std::mutex> lock(convert_mutex);
+            file_system_scope files(options.files);
+            detail::diagnostic_capture capture;
+            try {
+                reset_prefetch();
+                clear_loaded_files();
+                clear_snippet_cache();
+                clear_interned_paths();
+                file_ptr f = load(path);
+                source.assign(f->source().begin(), f->source().end());
+                clear_loaded_files();
+            } catch (load_error& e) {
+                detail::outerr(path) << e.what() << std::endl;
+                convert_result result;
+                result.diagnostics = capture.diagnostics();
+                return result;
+            }
+        }
+
+        return convert(path, source, options);
+    }
+}
@@ -0,0 +1,107 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+// Converting documents in memory
+//
+// This is the interface for using quickbook as a library (built by the
+// 'quickbook-library' target). A document's source is passed in as a
+// string, and the generated boostbook or html is returned along with any
+// errors and warnings, so nothing is written to disk and nothing is
+// printed to the console.
+//
+// Included files are read through a 'file_system' (see vfs.hpp), so a
+// document and everything it includes can be kept in memory.
+//
+// Quickbook uses a lot of global state, so conversions are run one at a
+// time, calls from other threads wait for the current one to finish.
+
+#if !defined(BOOST_QUICKBOOK_CONVERT_HPP)
+#define BOOST_QUICKBOOK_CONVERT_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/filesystem/path.hpp>
+#include "path.hpp"
+#include "stream.hpp"
+#include "string_view.hpp"
+#include "vfs.hpp"
+
+namespace quickbook
+{
+    namespace fs = boost::filesystem;
+
+    struct convert_options
+    {
+        enum output_format
+        {
+            boostbook,
+            html
+        };
+
+        convert_options();
+
+        output_format format;
+        // For html, whether to split the document into several pages.
+        bool chunked_output;
+        bool pretty_print;
+        int indent;
+        int linewidth;
+        bool strict_mode;
+        bool self_linked_headers;
+        // Use a fixed date, like '--debug', so that the output is stable.
+        bool fixed_date;
+        std::vector<fs::path> include_path;
+        std::vector<std::string> defines;
+        // Where images are found, to get the size of svg files. Defaults to
+        // the 'html' directory next to the document.
+        fs::path image_location;
+        // Paths in xincludes are relative to this. Defaults to the
+        // document's directory.
+        fs::path xinclude_base;
+        // Where the top level html page would be written, links to other
+        // files are made relative to it. Defaults to the same location as
+        // the command line tool.
+        fs::path home_path;
+        detail::path_or_url boost_root_path;
+        detail::path_or_url css_path;
+        detail::path_or_url graphics_path;
+        // Used for all file access during the conversion, if set. The
+        // native file system is used otherwise.
+        file_system* files;
+    };
+
+    struct convert_result
+    {
+        convert_result();
+
+        bool success;
+        std::string boostbook;
+        // The html pages, keyed by their generic path relative to the
+        // output directory.
+        std::map<std::string, std::string> html;
+        std::vector<detail::diagnostic> diagnostics;
+        // The files that the document used, in the same format as
+        // '--output-deps'.
+        std::string dependencies;
+    };
+
+    // Convert 'source' as if it was the contents of 'path'. Relative
+    // includes and imports are found from the directory of 'path', and
+    // are read from 'options.files'.
+    convert_result convert(
+        fs::path const& path,
+        quickbook::string_view source,
+        convert_options const& = convert_options());
+
+    // Convert a file read from 'options.files'.
+    convert_result convert_file(
+        fs::path const& path, convert_options const& = convert_options());
+}
+
+#endif
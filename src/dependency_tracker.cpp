@@ -7,10 +7,10 @@
 =============================================================================*/
 
 #include "dependency_tracker.hpp"
-#include <boost/filesystem/fstream.hpp>
-#include <boost/filesystem/operations.hpp>
+#include <sstream>
 #include "for.hpp"
 #include "path.hpp"
+#include "vfs.hpp"
 
 namespace quickbook
 {
@@ -62,7 +62,7 @@ namespace quickbook
 
     bool dependency_tracker::add_dependency(fs::path const& f)
     {
-        bool found = fs::exists(fs::status(f));
+        bool found = get_file_system().status(f).exists;
         dependencies[f] |= found;
         return found;
     }
@@ -83,16 +83,14 @@ namespace quickbook
     void dependency_tracker::write_dependencies(
         fs::path const& file_out, flags f)
     {
-        fs::ofstream out(file_out);
+        std::ostringstream out;
+        write_dependencies(out, f);
 
-        if (out.fail()) {
+        if (!get_file_system().write(file_out, out.str())) {
             throw std::runtime_error(
-                "Error opening dependency file " +
+                "Error writing dependency file " +
                 quickbook::detail::path_to_generic(file_out));
         }
-
-        out.exceptions(std::ios::badbit);
-        write_dependencies(out, f);
     }
 
     void dependency_tracker::write_dependencies(std::ostream& out, flags f)
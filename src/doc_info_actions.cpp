@@ -11,7 +11,6 @@
 #include <sstream>
 #include <boost/algorithm/string/join.hpp>
 #include <boost/bind/bind.hpp>
-#include <boost/filesystem/operations.hpp>
 #include "doc_info_tags.hpp"
 #include "document_state.hpp"
 #include "files.hpp"
@@ -21,6 +20,7 @@
 #include "state.hpp"
 #include "stream.hpp"
 #include "utils.hpp"
+#include "vfs.hpp"
 
 using namespace boost::placeholders;
 
@@ -328,7 +328,7 @@ namespace quickbook
             if (x.type == path_parameter::path) {
                 quickbook_path path = resolve_xinclude_path(x.value, state);
 
-                if (!fs::is_directory(path.file_path)) {
+                if (!get_file_system().status(path.file_path).is_directory) {
                     detail::outerr(
                         info.xmlbase.get_file(), info.xmlbase.get_position())
                         << "xmlbase \"" << info.xmlbase.get_quickbook()
@@ -198,6 +198,14 @@ namespace quickbook
         return replace_ids(*state, xml, &ids);
     }
 
+    void document_state::replace_placeholders(
+        spill_file& in, spill_file& out) const
+    {
+        assert(!state->current_file);
+        std::vector<std::string> ids = generate_ids(*state, in);
+        replace_ids(*state, in, out, &ids);
+    }
+
     unsigned document_state::compatibility_version() const
     {
         return state->current_file->compatibility_version;
@@ -46,6 +46,7 @@ namespace quickbook
     };
 
     struct document_state_impl;
+    class spill_file;
 
     struct document_state
     {
@@ -83,6 +84,11 @@ namespace quickbook
         std::string replace_placeholders_with_unresolved_ids(
             quickbook::string_view) const;
         std::string replace_placeholders(quickbook::string_view) const;
+        // For documents which are too large to keep in memory. 'in' is
+        // read twice, as ids can only be generated after all the
+        // placeholders have been found, and the result is written to
+        // 'out'.
+        void replace_placeholders(spill_file& in, spill_file& out) const;
 
         unsigned compatibility_version() const;
 
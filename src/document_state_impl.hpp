@@ -63,6 +63,7 @@ namespace quickbook
 
     struct file_info;
     struct doc_info;
+    class spill_file;
     struct section_info;
 
     struct document_state_impl
@@ -123,6 +124,15 @@ namespace quickbook
     std::vector<std::string> generate_ids(
         document_state_impl const&, quickbook::string_view);
 
+    // Versions for xml which is read from a file in blocks.
+    void replace_ids(
+        document_state_impl const& state,
+        spill_file& in,
+        spill_file& out,
+        std::vector<std::string> const* = 0);
+    std::vector<std::string> generate_ids(
+        document_state_impl const&, spill_file&);
+
     std::string normalize_id(quickbook::string_view src_id);
     std::string normalize_id(quickbook::string_view src_id, std::size_t);
 
@@ -137,10 +147,6 @@ namespace quickbook
 
     struct xml_processor
     {
-        xml_processor();
-
-        std::vector<std::string> id_attributes;
-
         struct callback
         {
             virtual void start(quickbook::string_view) {}
@@ -149,7 +155,13 @@ namespace quickbook
             virtual ~callback() {}
         };
 
-        void parse(quickbook::string_view, callback&);
+        // If 'last' is false, the source is part of a larger document,
+        // so parsing stops before any markup which might continue past
+        // the end. Returns where parsing stopped, so that the rest can be
+        // parsed again with the next part of the document. The callback's
+        // 'finish' is passed the part which was parsed.
+        string_iterator parse(
+            quickbook::string_view, callback&, bool last = true);
     };
 }
 
@@ -8,16 +8,21 @@
     http://www.boost.org/LICENSE_1_0.txt)
 =============================================================================*/
 #include "files.hpp"
-#include <fstream>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <iterator>
-#include <vector>
 #include <list>
-#include <boost/filesystem/fstream.hpp>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <boost/range/algorithm/transform.hpp>
 #include <boost/range/algorithm/upper_bound.hpp>
 #include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
 #include <boost/tuple/tuple.hpp>
 #include "for.hpp"
+#include "vfs.hpp"
 
 namespace quickbook
 {
@@ -107,25 +112,291 @@ namespace quickbook
         }
     }
 
+    // Read and normalize a file, throws load_error on failure.
+    static void read_file(
+        file_system& vfs, fs::path const& filename, std::string& source)
+    {
+        std::string text;
+        if (!vfs.read(filename, text)) {
+            throw load_error("Could not open input file.");
+        }
+
+        normalize(text.begin(), text.end(), std::back_inserter(source));
+    }
+
+    //
+    // Prefetching
+    //
+    // Files are read on background threads, and the normalized source is
+    // kept until 'load' is called for the file. Only the text is created in
+    // the background, the 'file' objects (which aren't thread safe) are
+    // still created by 'load'. Any errors are ignored in the background,
+    // the file is just read again by 'load', which reports them.
+    //
+    // If a request has a scanner, it's used to find the files included by
+    // the file that's read, which are then also prefetched. So the whole of
+    // an include tree can be read before the parser reaches it, rather
+    // than just one level at a time.
+
+    namespace
+    {
+        struct prefetcher
+        {
+            enum entry_state
+            {
+                pending,
+                reading,
+                done
+            };
+
+            struct entry
+            {
+                entry_state state;
+                std::string source;
+
+                entry() : state(pending), source() {}
+            };
+
+            typedef std::vector<fs::path> request;
+
+            // The file system is stored in the job, as the current file
+            // system can be changed while the prefetch threads are running.
+            struct job
+            {
+                request candidates;
+                prefetch_scanner_ptr scanner;
+                file_system* vfs;
+            };
+
+            std::mutex mutex;
+            std::condition_variable finished;
+            std::condition_variable queued;
+            std::deque<job> queue;
+            boost::unordered_map<fs::path, entry> entries;
+            // Every file that's been requested, so that scanning doesn't
+            // follow include cycles.
+            boost::unordered_set<fs::path> requested;
+            std::vector<std::thread> threads;
+            unsigned max_threads;
+            // The number of jobs that are being run.
+            unsigned active;
+            bool stopping;
+
+            prefetcher()
+                : max_threads(std::min(4u, std::thread::hardware_concurrency()))
+                , active(0)
+                , stopping(false)
+            {
+                if (!max_threads) max_threads = 1;
+            }
+
+            ~prefetcher()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stopping = true;
+                }
+                queued.notify_all();
+                QUICKBOOK_FOR (std::thread& t, threads) {
+                    t.join();
+                }
+            }
+
+            void add(
+                request const& candidates,
+                prefetch_scanner_ptr scanner,
+                file_system* vfs)
+            {
+                if (!max_threads) return;
+
+                std::unique_lock<std::mutex> lock(mutex);
+                add_locked(candidates, scanner, vfs);
+                lock.unlock();
+                queued.notify_one();
+            }
+
+            // pre: mutex is locked
+            void add_locked(
+                request const& candidates,
+                prefetch_scanner_ptr scanner,
+                file_system* vfs)
+            {
+                requested.insert(candidates.front());
+                queue.push_back(job());
+                queue.back().candidates = candidates;
+                queue.back().scanner = scanner;
+                queue.back().vfs = vfs;
+                QUICKBOOK_FOR (fs::path const& p, candidates) {
+                    entries[p];
+                }
+                if (threads.size() < max_threads) {
+                    threads.push_back(std::thread(&prefetcher::run, this));
+                }
+            }
+
+            // Claim a file that was prefetched, returns false if it
+            // hasn't been read.
+            bool take(fs::path const& filename, std::string& source)
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                boost::unordered_map<fs::path, entry>::iterator pos =
+                    entries.find(filename);
+                if (pos == entries.end()) return false;
+
+                // Not started yet, so quicker to read it here.
+                if (pos->second.state == pending) {
+                    entries.erase(pos);
+                    return false;
+                }
+
+                while (pos->second.state == reading) {
+                    finished.wait(lock);
+                    pos = entries.find(filename);
+                    if (pos == entries.end()) return false;
+                }
+
+                source.swap(pos->second.source);
+                entries.erase(pos);
+                return true;
+            }
+
+            void reset()
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                queue.clear();
+                while (active) {
+                    finished.wait(lock);
+                }
+                // The jobs that were running might have queued more files.
+                queue.clear();
+                entries.clear();
+                requested.clear();
+            }
+
+            void run()
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                for (;;) {
+                    while (!stopping && queue.empty()) {
+                        queued.wait(lock);
+                    }
+                    if (stopping) return;
+
+                    request candidates;
+                    candidates.swap(queue.front().candidates);
+                    prefetch_scanner_ptr scanner = queue.front().scanner;
+                    file_system* vfs = queue.front().vfs;
+                    queue.pop_front();
+                    ++active;
+
+                    // Read the first candidate that exists.
+                    request::iterator it = candidates.begin();
+                    for (; it != candidates.end(); ++it) {
+                        boost::unordered_map<fs::path, entry>::iterator pos =
+                            entries.find(*it);
+                        if (pos == entries.end()) {
+                            // Claimed by 'load', so it's been found.
+                            break;
+                        }
+                        if (pos->second.state != pending) break;
+
+                        pos->second.state = reading;
+                        lock.unlock();
+
+                        std::string source;
+                        std::vector<request> nested;
+                        bool found = vfs->status(*it).exists;
+                        bool success = false;
+                        if (found) {
+                            try {
+                                read_file(*vfs, *it, source);
+                                success = true;
+                                if (scanner) scanner->scan(*it, source, nested);
+                            } catch (std::exception&) {
+                            }
+                        }
+
+                        lock.lock();
+                        pos = entries.find(*it);
+                        if (success) {
+                            pos->second.state = done;
+                            pos->second.source.swap(source);
+                        }
+                        else {
+                            entries.erase(pos);
+                        }
+                        finished.notify_all();
+
+                        bool added = false;
+                        QUICKBOOK_FOR (request const& r, nested) {
+                            if (!requested.count(r.front())) {
+                                add_locked(r, scanner, vfs);
+                                added = true;
+                            }
+                        }
+                        if (added) queued.notify_all();
+
+                        if (found) break;
+                    }
+
+                    // Drop the candidates that weren't used.
+                    if (it != candidates.end()) ++it;
+                    for (; it != candidates.end(); ++it) {
+                        boost::unordered_map<fs::path, entry>::iterator pos =
+                            entries.find(*it);
+                        if (pos != entries.end() &&
+                            pos->second.state == pending) {
+                            entries.erase(pos);
+                        }
+                    }
+
+                    --active;
+                    if (!active) finished.notify_all();
+                }
+            }
+        };
+
+        prefetcher& get_prefetcher()
+        {
+            static prefetcher p;
+            return p;
+        }
+    }
+
+    prefetch_scanner::~prefetch_scanner() {}
+
+    void set_prefetch_threads(unsigned count)
+    {
+        get_prefetcher().max_threads = count;
+    }
+
+    void prefetch(
+        std::vector<fs::path> const& candidates, prefetch_scanner_ptr scanner)
+    {
+        std::vector<fs::path> filtered;
+        QUICKBOOK_FOR (fs::path const& p, candidates) {
+            if (files.find(p) != files.end()) return;
+            filtered.push_back(p);
+        }
+        if (!filtered.empty()) {
+            get_prefetcher().add(filtered, scanner, &get_file_system());
+        }
+    }
+
+    void reset_prefetch() { get_prefetcher().reset(); }
+
     file_ptr load(fs::path const& filename, unsigned qbk_version)
     {
         boost::unordered_map<fs::path, file_ptr>::iterator pos =
             files.find(filename);
 
         if (pos == files.end()) {
-            fs::ifstream in(filename, std::ios_base::in);
-
-            if (!in) throw load_error("Could not open input file.");
-
-            // Turn off white space skipping on the stream
-            in.unsetf(std::ios::skipws);
-
             std::string source;
-            normalize(
-                std::istream_iterator<char>(in), std::istream_iterator<char>(),
-                std::back_inserter(source));
-
-            if (in.bad()) throw load_error("Error reading input file.");
+            if (!get_prefetcher().take(filename, source)) {
+                read_file(get_file_system(), filename, source);
+            }
 
             bool inserted;
 
@@ -138,6 +409,21 @@ namespace quickbook
         return pos->second;
     }
 
+    file_ptr add_file(
+        fs::path const& filename,
+        quickbook::string_view text,
+        unsigned qbk_version)
+    {
+        std::string source;
+        normalize(text.begin(), text.end(), std::back_inserter(source));
+
+        file_ptr f(new file(filename, source, qbk_version));
+        files[filename] = f;
+        return f;
+    }
+
+    void clear_loaded_files() { files.clear(); }
+
     std::ostream& operator<<(std::ostream& out, file_position const& x)
     {
         return out << "line: " << x.line << ", column: " << x.column;
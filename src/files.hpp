@@ -15,8 +15,10 @@
 #include <iosfwd>
 #include <stdexcept>
 #include <string>
+#include <vector>
 #include <boost/filesystem/path.hpp>
 #include <boost/intrusive_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 #include "string_view.hpp"
 
 namespace quickbook
@@ -118,6 +120,51 @@ namespace quickbook
     // If version isn't supplied then it must be set later.
     file_ptr load(fs::path const& filename, unsigned qbk_version = 0);
 
+    // Use 'text' as the contents of 'filename', instead of reading it. It's
+    // normalized in the same way as a file that's read.
+    file_ptr add_file(
+        fs::path const& filename,
+        quickbook::string_view text,
+        unsigned qbk_version = 0);
+
+    // Forget the files that have been loaded, so that they're read again
+    // when next used.
+    void clear_loaded_files();
+
+    // Finds the files included by a prefetched file. 'scan' is called on a
+    // prefetch thread with the file's normalized source, and adds the
+    // candidate lists for any files it includes to the final argument. It
+    // mustn't use any global state, as the parser can change it while the
+    // prefetch threads are running.
+    struct prefetch_scanner
+    {
+        virtual ~prefetch_scanner();
+        virtual void scan(
+            fs::path const&,
+            quickbook::string_view,
+            std::vector<std::vector<fs::path> >&) const = 0;
+    };
+
+    typedef boost::shared_ptr<prefetch_scanner const> prefetch_scanner_ptr;
+
+    // Start reading a file in the background, so that it's ready when
+    // 'load' is called for it. 'candidates' are the possible locations,
+    // in the order they're searched, only the first that exists is read.
+    // If 'scanner' is set, the files it finds are also prefetched, using
+    // the same scanner.
+    void prefetch(
+        std::vector<fs::path> const& candidates,
+        prefetch_scanner_ptr scanner = prefetch_scanner_ptr());
+
+    // Discard the files that have been prefetched, but not loaded, and
+    // any that are waiting to be read. Waits for the files that are being
+    // read, so the prefetch threads are idle once it returns. Call when a
+    // document is finished, as some of the files might never be loaded.
+    void reset_prefetch();
+
+    // Maximum number of threads used for prefetching, 0 disables it.
+    void set_prefetch_threads(unsigned);
+
     struct load_error : std::runtime_error
     {
         explicit load_error(std::string const& arg) : std::runtime_error(arg) {}
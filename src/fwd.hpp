@@ -22,6 +22,7 @@ namespace quickbook
     struct section_info;
     struct file;
     struct template_symbol;
+    struct template_library;
     typedef boost::intrusive_ptr<file> file_ptr;
     typedef unsigned source_mode_type;
 
@@ -8,6 +8,7 @@
 
 #include "glob.hpp"
 #include <cassert>
+#include <vector>
 
 namespace quickbook
 {
@@ -57,11 +58,18 @@ namespace quickbook
 
             case '*':
                 is_glob = true;
-                ++begin;
 
-                if (begin != end && *begin == '*') {
-                    throw glob_error("'**' not supported");
+                // '**' is only allowed as a complete path segment, where it
+                // matches any number of directories.
+                if (begin + 1 != end && *(begin + 1) == '*') {
+                    if ((begin != pattern.begin() && *(begin - 1) != '/') ||
+                        (begin + 2 != end && *(begin + 2) != '/')) {
+                        throw glob_error(
+                            "'**' must be a complete path segment");
+                    }
+                    ++begin;
                 }
+                ++begin;
                 break;
 
             default:
@@ -127,9 +135,60 @@ namespace quickbook
         ++begin;
     }
 
+    namespace
+    {
+        typedef std::vector<quickbook::string_view> path_segments;
+
+        // Split a generic path at its slashes. Slashes can't be escaped,
+        // so this doesn't need to worry about escape characters.
+        path_segments split_path(quickbook::string_view path)
+        {
+            path_segments result;
+
+            for (;;) {
+                std::size_t pos = path.find('/');
+                if (pos == quickbook::string_view::npos) {
+                    result.push_back(path);
+                    return result;
+                }
+                result.push_back(quickbook::string_view(path.data(), pos));
+                path.remove_prefix(pos + 1);
+            }
+        }
+
+        bool match_segments(
+            path_segments const& pattern,
+            std::size_t i,
+            path_segments const& path,
+            std::size_t j)
+        {
+            for (; i < pattern.size(); ++i, ++j) {
+                if (pattern[i] == "**") {
+                    // Matches any number of segments, including none.
+                    for (std::size_t k = j; k <= path.size(); ++k) {
+                        if (match_segments(pattern, i + 1, path, k)) {
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+                if (j == path.size() || !glob(pattern[i], path[j])) {
+                    return false;
+                }
+            }
+
+            return j == path.size();
+        }
+    }
+
     // Does filename match pattern?
     // Might throw glob_error if pattern is an invalid glob,
     // but should call check_glob first to validate the glob.
+    //
+    // If either contains a slash, or the pattern is '**', the filename is
+    // matched as a generic path, one segment at a time, so that '*' doesn't
+    // match slashes and '**' matches any number of directories.
     bool glob(
         quickbook::string_view const& pattern,
         quickbook::string_view const& filename)
@@ -138,6 +197,13 @@ namespace quickbook
         // empty string.
         if (filename.empty()) return pattern.empty();
 
+        if (pattern == "**" ||
+            pattern.find('/') != quickbook::string_view::npos ||
+            filename.find('/') != quickbook::string_view::npos) {
+            return match_segments(
+                split_path(pattern), 0, split_path(filename), 0);
+        }
+
         glob_iterator pattern_it = pattern.begin();
         glob_iterator pattern_end = pattern.end();
 
@@ -154,7 +220,7 @@ namespace quickbook
             if (pattern_it == pattern_end) return true;
 
             if (*pattern_it == '*') {
-                throw glob_error("'**' not supported");
+                throw glob_error("'**' must be a complete path segment");
             }
 
             for (;;) {
@@ -346,4 +412,266 @@ namespace quickbook
 
         return result;
     }
+
+    //
+    // compiled_glob
+    //
+
+    compiled_glob::compiled_glob(quickbook::string_view pattern)
+        : empty_(pattern.empty()), is_path_(false), segments_(), ranges_()
+    {
+        check_glob(pattern);
+
+        path_segments parts = split_path(pattern);
+        is_path_ = parts.size() > 1 || pattern == "**";
+        segments_.resize(parts.size());
+
+        for (std::size_t i = 0; i < parts.size(); ++i) {
+            if (parts[i] == "**") {
+                segments_[i].recursive = true;
+            }
+            else {
+                compile_segment(segments_[i], parts[i]);
+            }
+        }
+    }
+
+    void compiled_glob::compile_segment(
+        segment& seg, quickbook::string_view pattern)
+    {
+        glob_iterator it = pattern.begin();
+        glob_iterator end = pattern.end();
+
+        seg.sections.push_back(0);
+
+        while (it != end) {
+            switch (*it) {
+            case '*':
+                seg.sections.push_back(seg.program.size());
+                ++it;
+                break;
+            case '?':
+                seg.program.push_back(instruction(instruction::match_any, 0));
+                ++it;
+                break;
+            case '[': {
+                // Parsed in the same way as match_range.
+                std::bitset<256> range;
+                bool invert_match = false;
+
+                ++it;
+                if (it == end) throw glob_error("uneven square brackets");
+
+                if (*it == '^') {
+                    invert_match = true;
+                    ++it;
+                    if (it == end) throw glob_error("uneven square brackets");
+                }
+                else if (*it == ']') {
+                    throw glob_error("empty range");
+                }
+
+                for (;;) {
+                    unsigned char first = *it;
+                    ++it;
+                    if (first == ']') break;
+                    if (first == '[') {
+                        throw glob_error("nested square brackets");
+                    }
+                    if (it == end) throw glob_error("uneven square brackets");
+
+                    if (first == '\\') {
+                        first = *it;
+                        if (first == '\\' || first == '/') {
+                            throw glob_error("contains escaped slash");
+                        }
+                        ++it;
+                        if (it == end) {
+                            throw glob_error("uneven square brackets");
+                        }
+                    }
+                    else if (first == '/') {
+                        throw glob_error("slash in square brackets");
+                    }
+
+                    if (*it != '-') {
+                        range.set(first);
+                        continue;
+                    }
+
+                    ++it;
+                    if (it == end) throw glob_error("uneven square brackets");
+
+                    unsigned char second = *it;
+                    ++it;
+                    if (second == ']') {
+                        range.set(first);
+                        range.set('-');
+                        break;
+                    }
+                    if (it == end) throw glob_error("uneven square brackets");
+
+                    if (second == '\\') {
+                        second = *it;
+                        if (second == '\\' || second == '/') {
+                            throw glob_error("contains escaped slash");
+                        }
+                        ++it;
+                        if (it == end) {
+                            throw glob_error("uneven square brackets");
+                        }
+                    }
+                    else if (second == '/') {
+                        throw glob_error("slash in square brackets");
+                    }
+
+                    for (unsigned c = first; c <= second; ++c) {
+                        range.set(c);
+                    }
+                }
+
+                // 'glob' compares the range against a 'char', so characters
+                // outside of ASCII are never in a range.
+                for (unsigned c = 128; c < 256; ++c) {
+                    range.reset(c);
+                }
+                if (invert_match) range.flip();
+
+                seg.program.push_back(
+                    instruction(instruction::match_range, ranges_.size()));
+                ranges_.push_back(range);
+                break;
+            }
+            case ']':
+                throw glob_error("uneven square brackets");
+            case '\\':
+                ++it;
+                if (it == end) {
+                    throw glob_error("trailing escape");
+                }
+                else if (*it == '\\' || *it == '/') {
+                    throw glob_error("contains escaped slash");
+                }
+                BOOST_FALLTHROUGH;
+            default:
+                seg.program.push_back(instruction(
+                    instruction::match_char, static_cast<unsigned char>(*it)));
+                ++it;
+            }
+        }
+
+        seg.sections.push_back(seg.program.size());
+
+        // Literal characters at the start of the first section and the end
+        // of the last, for quickly rejecting filenames.
+        for (std::size_t i = 0; i < seg.sections[1]; ++i) {
+            if (seg.program[i].op != instruction::match_char) break;
+            seg.prefix += static_cast<char>(seg.program[i].value);
+        }
+        for (std::size_t i = seg.program.size();
+             i > seg.sections[seg.sections.size() - 2]; --i) {
+            if (seg.program[i - 1].op != instruction::match_char) break;
+            seg.suffix.insert(
+                seg.suffix.begin(), static_cast<char>(seg.program[i - 1].value));
+        }
+    }
+
+    bool compiled_glob::match(quickbook::string_view filename) const
+    {
+        // Same special case as 'glob'.
+        if (filename.empty()) return empty_;
+
+        if (is_path_ || filename.find('/') != quickbook::string_view::npos) {
+            return match_path(0, split_path(filename), 0);
+        }
+
+        return segments_.size() == 1 && !segments_[0].recursive &&
+               match_segment(segments_[0], filename);
+    }
+
+    bool compiled_glob::match_path(
+        std::size_t i, path_segments const& path, std::size_t j) const
+    {
+        for (; i < segments_.size(); ++i, ++j) {
+            if (segments_[i].recursive) {
+                for (std::size_t k = j; k <= path.size(); ++k) {
+                    if (match_path(i + 1, path, k)) return true;
+                }
+                return false;
+            }
+
+            if (j == path.size() || !match_segment(segments_[i], path[j])) {
+                return false;
+            }
+        }
+
+        return j == path.size();
+    }
+
+    bool compiled_glob::match_segment(
+        segment const& seg, quickbook::string_view filename) const
+    {
+        std::size_t last = seg.sections.size() - 2;
+
+        // A single '*' doesn't match an empty string.
+        if (filename.empty()) return seg.program.empty() && last == 0;
+        if (filename.size() < seg.program.size()) return false;
+
+        if (filename.substr(0, seg.prefix.size()) != seg.prefix ||
+            filename.substr(filename.size() - seg.suffix.size()) !=
+                seg.suffix) {
+            return false;
+        }
+
+        glob_iterator it = filename.begin();
+        glob_iterator end = filename.end();
+
+        if (last == 0) {
+            return filename.size() == seg.program.size() &&
+                   match_section(seg, 0, it);
+        }
+
+        // The first section must be at the start.
+        if (!match_section(seg, 0, it)) return false;
+        it += seg.sections[1];
+
+        // Then find the first match for each section in the middle.
+        for (std::size_t s = 1; s < last; ++s) {
+            std::size_t length = seg.sections[s + 1] - seg.sections[s];
+            for (;;) {
+                if (static_cast<std::size_t>(end - it) < length) return false;
+                if (match_section(seg, s, it)) break;
+                ++it;
+            }
+            it += length;
+        }
+
+        // The last section must be at the end.
+        std::size_t length = seg.program.size() - seg.sections[last];
+        if (static_cast<std::size_t>(end - it) < length) return false;
+        return match_section(seg, last, end - length);
+    }
+
+    bool compiled_glob::match_section(
+        segment const& seg, std::size_t s, glob_iterator it) const
+    {
+        for (std::size_t i = seg.sections[s]; i < seg.sections[s + 1];
+             ++i, ++it) {
+            instruction const& x = seg.program[i];
+            unsigned char c = *it;
+
+            switch (x.op) {
+            case instruction::match_char:
+                if (c != x.value) return false;
+                break;
+            case instruction::match_any:
+                break;
+            case instruction::match_range:
+                if (!ranges_[x.value][c]) return false;
+                break;
+            }
+        }
+
+        return true;
+    }
 }
@@ -9,7 +9,10 @@
 #if !defined(BOOST_QUICKBOOK_GLOB_HPP)
 #define BOOST_QUICKBOOK_GLOB_HPP
 
+#include <bitset>
 #include <stdexcept>
+#include <string>
+#include <vector>
 #include "string_view.hpp"
 
 namespace quickbook
@@ -27,6 +30,71 @@ namespace quickbook
         quickbook::string_view const& pattern,
         quickbook::string_view const& filename);
 
+    // A glob preprocessed into a simple matcher, for matching the same
+    // pattern against a lot of filenames. Matches exactly the same
+    // filenames as 'glob'.
+    //
+    // Throws glob_error if the pattern is invalid.
+    struct compiled_glob
+    {
+        explicit compiled_glob(quickbook::string_view pattern);
+
+        bool match(quickbook::string_view filename) const;
+
+      private:
+        struct instruction
+        {
+            enum op_type
+            {
+                match_char,
+                match_any,
+                match_range
+            };
+
+            op_type op;
+            unsigned value; // The character, or index of the range
+
+            instruction(op_type op_, unsigned value_) : op(op_), value(value_)
+            {
+            }
+        };
+
+        // A path segment, which is a list of sections separated by '*'.
+        // The first section must match at the start of the filename, the
+        // last at the end, and any others are searched for in between.
+        struct segment
+        {
+            bool recursive; // '**'
+            std::vector<instruction> program;
+            std::vector<std::size_t> sections; // Offsets into program
+            std::string prefix;                // Literal characters that
+            std::string suffix;                // must be at the start/end.
+
+            segment()
+                : recursive(false)
+                , program()
+                , sections()
+                , prefix()
+                , suffix()
+            {
+            }
+        };
+
+        void compile_segment(segment&, quickbook::string_view);
+        bool match_path(
+            std::size_t, std::vector<quickbook::string_view> const&, std::size_t)
+            const;
+        bool match_segment(segment const&, quickbook::string_view) const;
+        bool match_section(
+            segment const&, std::size_t, quickbook::string_view::const_iterator)
+            const;
+
+        bool empty_;
+        bool is_path_;
+        std::vector<segment> segments_;
+        std::vector<std::bitset<256> > ranges_;
+    };
+
     std::size_t find_glob_char(quickbook::string_view, std::size_t start = 0);
     std::string glob_unescape(quickbook::string_view);
 }
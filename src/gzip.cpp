@@ -0,0 +1,36 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#include "gzip.hpp"
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+namespace quickbook
+{
+    namespace detail
+    {
+        namespace io = boost::iostreams;
+
+        std::string gzip_compress(quickbook::string_view data)
+        {
+            std::string result;
+
+            {
+                io::filtering_ostream out;
+                out.push(io::gzip_compressor(
+                    io::gzip_params(io::gzip::best_compression)));
+                out.push(io::back_inserter(result));
+                out.write(
+                    data.data(), static_cast<std::streamsize>(data.size()));
+            }
+
+            return result;
+        }
+    }
+}
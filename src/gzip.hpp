@@ -0,0 +1,26 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#if !defined(BOOST_QUICKBOOK_GZIP_HPP)
+#define BOOST_QUICKBOOK_GZIP_HPP
+
+#include <string>
+#include "string_view.hpp"
+
+namespace quickbook
+{
+    namespace detail
+    {
+        // Compress 'data' to the gzip file format, so that a web server can
+        // send it directly. The header doesn't contain a timestamp, so the
+        // same data is always compressed to the same result.
+        std::string gzip_compress(quickbook::string_view data);
+    }
+}
+
+#endif
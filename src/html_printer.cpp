@@ -7,12 +7,51 @@ http://www.boost.org/LICENSE_1_0.txt)
 =============================================================================*/
 
 #include "html_printer.hpp"
+#include <boost/algorithm/string/predicate.hpp>
+#include "pretty_printer.hpp"
 #include "utils.hpp"
 
 namespace quickbook
 {
     namespace detail
     {
+        html_printer::html_printer() : html(), pretty() {}
+        html_printer::~html_printer() {}
+
+        void start_pretty_print(html_printer& printer)
+        {
+            printer.pretty.reset(
+                new tidy_printer(printer.html, -1, -1, true));
+        }
+
+        bool end_pretty_print(html_printer& printer)
+        {
+            if (!printer.pretty) {
+                return true;
+            }
+
+            bool success = printer.pretty->finish();
+            printer.pretty.reset();
+            return success;
+        }
+
+        void print_html(html_printer& printer, quickbook::string_view x)
+        {
+            if (printer.pretty) {
+                printer.pretty->write(x);
+            }
+            else {
+                printer.html.append(x.begin(), x.end());
+            }
+        }
+
+        // Can a tag be printed without tokenizing it?
+        bool is_direct(html_printer& printer)
+        {
+            return printer.pretty && !printer.pretty->in_tag &&
+                   printer.pretty->pending.empty();
+        }
+
         void open_tag(html_printer& printer, quickbook::string_view name)
         {
             tag_start(printer, name);
@@ -21,31 +60,77 @@ namespace quickbook
 
         void close_tag(html_printer& printer, quickbook::string_view name)
         {
-            printer.html += "</";
-            printer.html.append(name.begin(), name.end());
-            printer.html += ">";
+            if (is_direct(printer)) {
+                tidy_printer& pretty = *printer.pretty;
+                bool flow = pretty.begin_close_tag();
+                pretty.printer.print('<');
+                pretty.printer.print('/');
+                pretty.printer.print(name.begin(), name.end());
+                pretty.printer.print('>');
+                pretty.end_empty_tag(flow);
+            }
+            else {
+                print_html(printer, "</");
+                print_html(printer, name);
+                print_html(printer, ">");
+            }
         }
 
         void tag_start(html_printer& printer, quickbook::string_view name)
         {
-            printer.html += "<";
-            printer.html.append(name.begin(), name.end());
+            // Preformatted text is written out in one go, so it has to be
+            // tokenized.
+            if (is_direct(printer) && !boost::starts_with(name, "pre")) {
+                tidy_printer& pretty = *printer.pretty;
+                pretty.in_tag = true;
+                pretty.tag_is_flow = pretty.is_flow_tag(name);
+                pretty.begin_tag(pretty.tag_is_flow);
+                pretty.printer.print('<');
+                pretty.printer.print(name.begin(), name.end());
+            }
+            else {
+                print_html(printer, "<");
+                print_html(printer, name);
+            }
         }
 
-        void tag_end(html_printer& printer) { printer.html += ">"; }
+        void tag_end(html_printer& printer)
+        {
+            if (printer.pretty && printer.pretty->in_tag) {
+                tidy_printer& pretty = *printer.pretty;
+                pretty.printer.print('>');
+                pretty.in_tag = false;
+                pretty.end_open_tag(pretty.tag_is_flow);
+            }
+            else {
+                print_html(printer, ">");
+            }
+        }
 
-        void tag_end_self_close(html_printer& printer) { printer.html += "/>"; }
+        void tag_end_self_close(html_printer& printer)
+        {
+            if (printer.pretty && printer.pretty->in_tag) {
+                tidy_printer& pretty = *printer.pretty;
+                pretty.printer.print('/');
+                pretty.printer.print('>');
+                pretty.in_tag = false;
+                pretty.end_empty_tag(pretty.tag_is_flow);
+            }
+            else {
+                print_html(printer, "/>");
+            }
+        }
 
         void tag_attribute(
             html_printer& printer,
             quickbook::string_view name,
             quickbook::string_view value)
         {
-            printer.html += " ";
-            printer.html.append(name.begin(), name.end());
-            printer.html += "=\"";
-            printer.html.append(encode_string(value));
-            printer.html += "\"";
+            print_html(printer, " ");
+            print_html(printer, name);
+            print_html(printer, "=\"");
+            print_html(printer, encode_string(value));
+            print_html(printer, "\"");
         }
     }
 }
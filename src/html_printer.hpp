@@ -9,11 +9,14 @@ http://www.boost.org/LICENSE_1_0.txt)
 #if !defined(BOOST_QUICKBOOK_BOOSTBOOK_HTML_PRINTER_HPP)
 #define BOOST_QUICKBOOK_BOOSTBOOK_HTML_PRINTER_HPP
 
+#include <memory>
 #include <string>
 #include "string_view.hpp"
 
 namespace quickbook
 {
+    struct tidy_printer;
+
     namespace detail
     {
         struct html_printer;
@@ -27,10 +30,27 @@ namespace quickbook
         void tag_start(html_printer&, quickbook::string_view name);
         void tag_end(html_printer&);
         void tag_end_self_close(html_printer&);
+        // Write markup or encoded text.
+        void print_html(html_printer&, quickbook::string_view);
+
+        // Indent the html as it's written, in the same manner as
+        // 'post_process', so that it doesn't have to be parsed again.
+        void start_pretty_print(html_printer&);
+        // Write anything that's pending, returns false if the html wasn't
+        // well formed, in which case it might be badly indented.
+        bool end_pretty_print(html_printer&);
 
         struct html_printer
         {
+            html_printer();
+            ~html_printer();
+
             std::string html;
+            std::unique_ptr<tidy_printer> pretty;
+
+          private:
+            html_printer(html_printer const&);
+            html_printer& operator=(html_printer const&);
         };
     }
 }
@@ -13,6 +13,7 @@
 #include <boost/unordered_map.hpp>
 #include "document_state_impl.hpp"
 #include "for.hpp"
+#include "spill_file.hpp"
 
 namespace quickbook
 {
@@ -24,9 +25,50 @@ namespace quickbook
 
     static const std::size_t max_size = 32;
 
+    //
+    // parse_blocks
+    //
+    // Runs the xml processor over xml which is read from a file in blocks.
+    // Markup which crosses the end of a block is kept to be parsed with
+    // the next block. 'after_block' is called after each part is parsed.
+    //
+
+    template <typename Function>
+    void parse_blocks(
+        spill_file& xml, xml_processor::callback& c, Function after_block)
+    {
+        xml_processor processor;
+        std::string buffer, block;
+        xml.rewind();
+
+        for (;;) {
+            bool more = xml.read(block);
+            if (buffer.empty()) {
+                buffer.swap(block);
+            }
+            else {
+                buffer += block;
+            }
+
+            string_iterator parsed = processor.parse(buffer, c, !more);
+            after_block();
+            buffer.erase(0, parsed - quickbook::string_view(buffer).begin());
+            if (!more) break;
+        }
+    }
+
+    void parse_blocks(spill_file& xml, xml_processor::callback& c)
+    {
+        parse_blocks(xml, c, []() {});
+    }
+
     typedef std::vector<id_placeholder const*> placeholder_index;
     placeholder_index index_placeholders(
         document_state_impl const&, quickbook::string_view);
+    placeholder_index index_placeholders(
+        document_state_impl const&, spill_file&);
+    std::vector<std::string> generate_ids(
+        document_state_impl const&, placeholder_index&);
 
     void generate_id_block(
         placeholder_index::iterator,
@@ -36,11 +78,23 @@ namespace quickbook
     std::vector<std::string> generate_ids(
         document_state_impl const& state, quickbook::string_view xml)
     {
-        std::vector<std::string> generated_ids(state.placeholders.size());
-
         // Get a list of the placeholders in the order that we wish to
         // process them.
         placeholder_index placeholders = index_placeholders(state, xml);
+        return generate_ids(state, placeholders);
+    }
+
+    std::vector<std::string> generate_ids(
+        document_state_impl const& state, spill_file& xml)
+    {
+        placeholder_index placeholders = index_placeholders(state, xml);
+        return generate_ids(state, placeholders);
+    }
+
+    std::vector<std::string> generate_ids(
+        document_state_impl const& state, placeholder_index& placeholders)
+    {
+        std::vector<std::string> generated_ids(state.placeholders.size());
 
         typedef std::vector<id_placeholder const*>::iterator iterator;
         iterator it = placeholders.begin(), end = placeholders.end();
@@ -120,6 +174,9 @@ namespace quickbook
         }
     };
 
+    placeholder_index sort_placeholders(
+        document_state_impl const& state, std::vector<unsigned>& order);
+
     placeholder_index index_placeholders(
         document_state_impl const& state, quickbook::string_view xml)
     {
@@ -130,6 +187,21 @@ namespace quickbook
         get_placeholder_order_callback callback(state, order);
         processor.parse(xml, callback);
 
+        return sort_placeholders(state, order);
+    }
+
+    placeholder_index index_placeholders(
+        document_state_impl const& state, spill_file& xml)
+    {
+        std::vector<unsigned> order(state.placeholders.size());
+        get_placeholder_order_callback callback(state, order);
+        parse_blocks(xml, callback);
+        return sort_placeholders(state, order);
+    }
+
+    placeholder_index sort_placeholders(
+        document_state_impl const& state, std::vector<unsigned>& order)
+    {
         placeholder_index sorted_placeholders;
         sorted_placeholders.reserve(state.placeholders.size());
         QUICKBOOK_FOR (id_placeholder const& p, state.placeholders)
@@ -329,6 +401,19 @@ namespace quickbook
         return callback.result;
     }
 
+    void replace_ids(
+        document_state_impl const& state,
+        spill_file& in,
+        spill_file& out,
+        std::vector<std::string> const* ids)
+    {
+        replace_ids_callback callback(state, ids);
+        parse_blocks(in, callback, [&]() {
+            out.write(callback.result);
+            callback.result.clear();
+        });
+    }
+
     //
     // normalize_id
     //
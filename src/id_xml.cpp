@@ -6,102 +6,131 @@
     http://www.boost.org/LICENSE_1_0.txt)
 =============================================================================*/
 
-#include <boost/range/algorithm/find.hpp>
-#include <boost/range/algorithm/sort.hpp>
+#include <vector>
 #include "document_state_impl.hpp"
+#include "for.hpp"
 #include "simple_parse.hpp"
+#include "string_table.hpp"
 #include "utils.hpp"
 
 namespace quickbook
 {
     namespace
     {
-        char const* id_attributes_[] = {"id", "linkend", "linkends",
-                                        "arearefs"};
-    }
+        // Sorted, see string_table.hpp.
+        constexpr detail::static_string id_attributes_[] = {
+            "arearefs", "id", "linkend", "linkends"};
 
-    xml_processor::xml_processor()
-    {
-        static std::size_t const n_id_attributes =
-            sizeof(id_attributes_) / sizeof(char const*);
-        for (int i = 0; i != n_id_attributes; ++i) {
-            id_attributes.push_back(id_attributes_[i]);
-        }
+        static_assert(
+            detail::is_sorted_table(id_attributes_),
+            "id_attributes_ isn't sorted");
 
-        boost::sort(id_attributes);
+        constexpr detail::string_table id_attributes(id_attributes_);
     }
 
-    void xml_processor::parse(quickbook::string_view source, callback& c)
+    string_iterator xml_processor::parse(
+        quickbook::string_view source, callback& c, bool last)
     {
         typedef string_iterator iterator;
 
         c.start(source);
 
         iterator it = source.begin(), end = source.end();
+        // Where parsing stopped, moved past each piece of markup once it's
+        // known to be complete.
+        iterator parsed = end;
+        // The id values in the current tag, which are only passed to the
+        // callback once the whole tag has been found.
+        std::vector<quickbook::string_view> values;
 
         for (;;) {
-            read_past(it, end, "<");
-            if (it == end) break;
+            if (!read_past(it, end, "<")) break;
+            iterator markup_start = it - 1;
+            if (it == end) {
+                // A '<' at the end could be the start of anything.
+                if (!last) parsed = markup_start;
+                break;
+            }
+
+            bool complete = true;
 
             if (read(it, end, "!--quickbook-escape-prefix-->")) {
-                read_past(it, end, "<!--quickbook-escape-postfix-->");
-                continue;
+                complete =
+                    read_past(it, end, "<!--quickbook-escape-postfix-->");
             }
+            else {
+                switch (*it) {
+                case '?':
+                    ++it;
+                    complete = read_past(it, end, "?>");
+                    break;
 
-            switch (*it) {
-            case '?':
-                ++it;
-                read_past(it, end, "?>");
-                break;
+                case '!':
+                    if (read(it, end, "!--"))
+                        complete = read_past(it, end, "-->");
+                    else
+                        complete = read_past(it, end, ">");
+                    break;
 
-            case '!':
-                if (read(it, end, "!--"))
-                    read_past(it, end, "-->");
-                else
-                    read_past(it, end, ">");
-                break;
+                default:
+                    if ((*it >= 'a' && *it <= 'z') ||
+                        (*it >= 'A' && *it <= 'Z') || *it == '_' ||
+                        *it == ':') {
+                        read_to_one_of(it, end, " \t\n\r>");
+                        values.clear();
+
+                        for (;;) {
+                            read_some_of(it, end, " \t\n\r");
+                            iterator name_start = it;
+                            read_to_one_of(it, end, "= \t\n\r>");
+                            if (it == end || *it == '>') break;
+                            quickbook::string_view name(
+                                name_start, it - name_start);
+                            ++it;
+
+                            read_some_of(it, end, "= \t\n\r");
+                            if (it == end || (*it != '"' && *it != '\''))
+                                break;
+
+                            char delim = *it;
+                            ++it;
+
+                            iterator value_start = it;
+
+                            it = std::find(it, end, delim);
+                            if (it == end) break;
+                            quickbook::string_view value(
+                                value_start, it - value_start);
+                            ++it;
+
+                            if (id_attributes.contains(name)) {
+                                values.push_back(value);
+                            }
+                        }
 
-            default:
-                if ((*it >= 'a' && *it <= 'z') || (*it >= 'A' && *it <= 'Z') ||
-                    *it == '_' || *it == ':') {
-                    read_to_one_of(it, end, " \t\n\r>");
-
-                    for (;;) {
-                        read_some_of(it, end, " \t\n\r");
-                        iterator name_start = it;
-                        read_to_one_of(it, end, "= \t\n\r>");
-                        if (it == end || *it == '>') break;
-                        quickbook::string_view name(
-                            name_start, it - name_start);
-                        ++it;
-
-                        read_some_of(it, end, "= \t\n\r");
-                        if (it == end || (*it != '"' && *it != '\'')) break;
-
-                        char delim = *it;
-                        ++it;
-
-                        iterator value_start = it;
-
-                        it = std::find(it, end, delim);
-                        if (it == end) break;
-                        quickbook::string_view value(
-                            value_start, it - value_start);
-                        ++it;
-
-                        if (boost::find(id_attributes, name.to_s()) !=
-                            id_attributes.end()) {
-                            c.id_value(value);
+                        complete = it != end;
+                        if (complete || last) {
+                            QUICKBOOK_FOR (
+                                quickbook::string_view value, values) {
+                                c.id_value(value);
+                            }
                         }
                     }
+                    else {
+                        complete = read_past(it, end, ">");
+                    }
                 }
-                else {
-                    read_past(it, end, ">");
-                }
+            }
+
+            if (!complete && !last) {
+                parsed = markup_start;
+                break;
             }
         }
 
-        c.finish(source);
+        c.finish(
+            quickbook::string_view(source.begin(), parsed - source.begin()));
+        return parsed;
     }
 
     namespace detail
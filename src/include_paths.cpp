@@ -10,9 +10,13 @@
 =============================================================================*/
 
 #include "include_paths.hpp"
+#include <algorithm>
 #include <cassert>
+#include <vector>
 #include <boost/filesystem.hpp>
 #include <boost/range/algorithm/replace.hpp>
+#include <boost/unordered_map.hpp>
+#include "files.hpp"
 #include "for.hpp"
 #include "glob.hpp"
 #include "path.hpp"
@@ -20,6 +24,7 @@
 #include "state.hpp"
 #include "stream.hpp"
 #include "utils.hpp"
+#include "vfs.hpp"
 
 namespace quickbook
 {
@@ -116,72 +121,276 @@ namespace quickbook
     // Search include path
     //
 
-    void include_search_glob(
-        std::set<quickbook_path>& result,
-        quickbook_path const& location,
-        std::string path,
-        quickbook::state& state)
+    namespace
     {
-        std::size_t glob_pos = find_glob_char(path);
+        // Directory listings are cached for the whole run, as documents
+        // often use several globs over the same directories, and each one
+        // is searched for in every include path.
+
+        struct directory_entry
+        {
+            std::string name; // Generic path
+            bool is_regular_file;
+            bool is_directory; // Not true for symbolic links
+
+            directory_entry(
+                std::string const& name_,
+                bool is_regular_file_,
+                bool is_directory_)
+                : name(name_)
+                , is_regular_file(is_regular_file_)
+                , is_directory(is_directory_)
+            {
+            }
+        };
 
-        if (glob_pos == std::string::npos) {
-            quickbook_path complete_path = location / glob_unescape(path);
+        // Each glob segment is only compiled once.
+        boost::unordered_map<std::string, compiled_glob> glob_cache;
 
-            if (fs::exists(complete_path.file_path)) {
-                state.dependencies.add_glob_match(complete_path.file_path);
-                result.insert(complete_path);
+        compiled_glob const& compile_glob(std::string const& glob)
+        {
+            boost::unordered_map<std::string, compiled_glob>::iterator pos =
+                glob_cache.find(glob);
+            if (pos == glob_cache.end()) {
+                pos = glob_cache.emplace(glob, compiled_glob(glob)).first;
             }
-            return;
+            return pos->second;
         }
 
-        std::size_t prev = path.rfind('/', glob_pos);
-        std::size_t next = path.find('/', glob_pos);
+        struct directory_listing
+        {
+            typedef std::vector<std::size_t> match_list;
+
+            bool is_directory;
+            std::vector<directory_entry> entries;
+
+            // Indexes of the entries matching each glob that's been used.
+            boost::unordered_map<std::string, match_list> matches;
+
+            directory_listing() : is_directory(false), entries(), matches() {}
+
+            match_list const& match(quickbook::string_view glob)
+            {
+                std::string key = glob.to_s();
+                boost::unordered_map<std::string, match_list>::iterator pos =
+                    matches.find(key);
+
+                if (pos == matches.end()) {
+                    compiled_glob const& compiled = compile_glob(key);
+                    match_list m;
+                    for (std::size_t i = 0; i < entries.size(); ++i) {
+                        if (compiled.match(entries[i].name)) {
+                            m.push_back(i);
+                        }
+                    }
+                    pos = matches.emplace(key, m).first;
+                }
+
+                return pos->second;
+            }
+        };
+
+        boost::unordered_map<fs::path, directory_listing> directory_cache;
 
-        std::size_t glob_begin = prev == std::string::npos ? 0 : prev + 1;
-        std::size_t glob_end = next == std::string::npos ? path.size() : next;
+        directory_listing& list_directory(fs::path const& dir)
+        {
+            boost::unordered_map<fs::path, directory_listing>::iterator pos =
+                directory_cache.find(dir);
+            if (pos != directory_cache.end()) return pos->second;
 
-        quickbook_path new_location = location;
+            directory_listing listing;
+            std::vector<file_system::entry> entries;
+            listing.is_directory = get_file_system().list(dir, entries);
+
+            QUICKBOOK_FOR (file_system::entry const& e, entries) {
+                listing.entries.push_back(directory_entry(
+                    detail::path_to_generic(e.name), e.is_regular_file,
+                    e.is_directory));
+            }
 
-        if (prev != std::string::npos) {
-            new_location /= glob_unescape(path.substr(0, prev));
+            return directory_cache.emplace(dir, listing).first->second;
         }
 
-        if (next != std::string::npos) ++next;
+        // A location in a glob walk. Unlike 'quickbook_path' its paths
+        // aren't interned, as most of the paths that are visited aren't
+        // matches.
+        struct glob_location
+        {
+            fs::path file_path;
+            unsigned include_path_offset;
+            fs::path abstract_file_path;
+
+            glob_location(
+                fs::path const& x, unsigned offset, fs::path const& y)
+                : file_path(x)
+                , include_path_offset(offset)
+                , abstract_file_path(y)
+            {
+            }
 
-        quickbook::string_view glob(
-            path.data() + glob_begin, glob_end - glob_begin);
+            explicit glob_location(quickbook_path const& x)
+                : file_path(x.file_path)
+                , include_path_offset(x.include_path_offset)
+                , abstract_file_path(x.abstract_file_path)
+            {
+            }
 
-        fs::path base_dir = new_location.file_path.empty()
-                                ? fs::path(".")
-                                : new_location.file_path;
-        if (!fs::is_directory(base_dir)) return;
+            glob_location operator/(quickbook::string_view x) const
+            {
+                return glob_location(*this) /= x;
+            }
 
-        // Walk through the dir for matches.
-        for (fs::directory_iterator dir_i(base_dir), dir_e; dir_i != dir_e;
-             ++dir_i) {
-            fs::path f = dir_i->path().filename();
-            std::string generic_path = detail::path_to_generic(f);
+            glob_location& operator/=(quickbook::string_view x)
+            {
+                fs::path x2 = detail::generic_to_path(x);
+                file_path /= x2;
+                abstract_file_path /= x2;
+                return *this;
+            }
 
-            // Skip if the dir item doesn't match.
-            if (!quickbook::glob(glob, generic_path)) continue;
+            quickbook_path path() const
+            {
+                return quickbook_path(
+                    file_path, include_path_offset, abstract_file_path);
+            }
+        };
+
+        template <typename Callback>
+        void glob_files(
+            glob_location const& location,
+            std::string const& path,
+            Callback& match);
+
+        // Match 'path' in 'location' and every directory below it, for
+        // '**' segments. Symbolic links aren't followed, to avoid cycles.
+        template <typename Callback>
+        void glob_files_recursive(
+            glob_location const& location,
+            std::string const& path,
+            Callback& match)
+        {
+            glob_files(location, path, match);
+
+            fs::path dir = location.file_path.empty() ? fs::path(".")
+                                                      : location.file_path;
+            directory_listing& listing = list_directory(dir);
+
+            QUICKBOOK_FOR (directory_entry const& entry, listing.entries) {
+                if (entry.is_directory) {
+                    glob_files_recursive(location / entry.name, path, match);
+                }
+            }
+        }
 
-            // If it's a file we add it to the results.
-            if (next == std::string::npos) {
-                if (fs::is_regular_file(dir_i->status())) {
-                    quickbook_path r = new_location / generic_path;
-                    state.dependencies.add_glob_match(r.file_path);
-                    result.insert(r);
+        // Find the files matching the glob 'path' in 'location', calling
+        // 'match' for each one.
+        template <typename Callback>
+        void glob_files(
+            glob_location const& location,
+            std::string const& path,
+            Callback& match)
+        {
+            std::size_t glob_pos = find_glob_char(path);
+
+            if (glob_pos == std::string::npos) {
+                glob_location complete_path = location / glob_unescape(path);
+
+                if (get_file_system().status(complete_path.file_path).exists) {
+                    match(complete_path.path());
                 }
+                return;
             }
-            // If it's a matching dir, we recurse looking for more files.
-            else {
-                if (!fs::is_regular_file(dir_i->status())) {
-                    include_search_glob(
-                        result, new_location / generic_path, path.substr(next),
-                        state);
+
+            std::size_t prev = path.rfind('/', glob_pos);
+            std::size_t next = path.find('/', glob_pos);
+
+            std::size_t glob_begin = prev == std::string::npos ? 0 : prev + 1;
+            std::size_t glob_end =
+                next == std::string::npos ? path.size() : next;
+
+            glob_location new_location = location;
+
+            if (prev != std::string::npos) {
+                new_location /= glob_unescape(path.substr(0, prev));
+            }
+
+            if (next != std::string::npos) ++next;
+
+            quickbook::string_view glob(
+                path.data() + glob_begin, glob_end - glob_begin);
+
+            // Only the directories below the non-wildcard prefix are
+            // walked. A trailing '**' matches every file, so is the same
+            // as '**/*'.
+            if (glob == "**") {
+                glob_files_recursive(
+                    new_location,
+                    next == std::string::npos ? std::string("*")
+                                              : path.substr(next),
+                    match);
+                return;
+            }
+
+            fs::path base_dir = new_location.file_path.empty()
+                                    ? fs::path(".")
+                                    : new_location.file_path;
+            directory_listing& listing = list_directory(base_dir);
+            if (!listing.is_directory) return;
+
+            // Walk through the matching items in the dir.
+            QUICKBOOK_FOR (std::size_t i, listing.match(glob)) {
+                directory_entry const& entry = listing.entries[i];
+
+                // If it's a file we add it to the results.
+                if (next == std::string::npos) {
+                    if (entry.is_regular_file) {
+                        match((new_location / entry.name).path());
+                    }
+                }
+                // If it's a matching dir, we recurse looking for more files.
+                else {
+                    if (!entry.is_regular_file) {
+                        glob_files(
+                            new_location / entry.name, path.substr(next),
+                            match);
+                    }
                 }
             }
         }
+
+        struct include_search_match
+        {
+            std::set<quickbook_path>& result;
+            quickbook::state& state;
+
+            include_search_match(
+                std::set<quickbook_path>& result_, quickbook::state& state_)
+                : result(result_), state(state_)
+            {
+            }
+
+            void operator()(quickbook_path const& path)
+            {
+                state.dependencies.add_glob_match(path.file_path);
+                result.insert(path);
+            }
+        };
+    }
+
+    void include_search_glob(
+        std::set<quickbook_path>& result,
+        quickbook_path const& location,
+        std::string path,
+        quickbook::state& state)
+    {
+        include_search_match match(result, state);
+        glob_files(glob_location(location), path, match);
+    }
+
+    void clear_directory_cache()
+    {
+        directory_cache.clear();
+        glob_cache.clear();
     }
 
     std::set<quickbook_path> include_search(
@@ -267,6 +476,179 @@ namespace quickbook
         }
     }
 
+    //
+    // Prefetch includes
+    //
+
+    namespace
+    {
+        struct prefetch_match
+        {
+            void operator()(quickbook_path const& path)
+            {
+                prefetch(std::vector<fs::path>(1, path.file_path));
+            }
+        };
+
+        bool is_space(char c) { return c == ' ' || c == '\t'; }
+
+        // Match '[include', '[include:id' or '[import' at 'it', and return
+        // the path that follows, or an empty string_view.
+        quickbook::string_view match_include(
+            string_iterator it, string_iterator end)
+        {
+            assert(*it == '[');
+            ++it;
+            while (it != end && is_space(*it))
+                ++it;
+
+            string_iterator name_start = it;
+            while (it != end && *it >= 'a' && *it <= 'z')
+                ++it;
+            quickbook::string_view name(name_start, it - name_start);
+
+            if (name == "include") {
+                if (it != end && *it == ':') {
+                    while (it != end && !is_space(*it) && *it != ']')
+                        ++it;
+                }
+            }
+            else if (name != "import") {
+                return quickbook::string_view();
+            }
+
+            if (it == end || !is_space(*it)) return quickbook::string_view();
+            while (it != end && is_space(*it))
+                ++it;
+
+            // Only look at plain paths, anything with markup or escapes
+            // is left for the parser.
+            string_iterator path_start = it;
+            for (; it != end && *it != ']'; ++it) {
+                switch (*it) {
+                case '[':
+                case '\\':
+                case '`':
+                case '"':
+                case '\n':
+                    return quickbook::string_view();
+                }
+            }
+            if (it == end) return quickbook::string_view();
+
+            while (it != path_start && is_space(*(it - 1)))
+                --it;
+
+            return quickbook::string_view(path_start, it - path_start);
+        }
+
+        // The places that a plain include path is searched for, in order.
+        std::vector<fs::path> include_candidates(
+            fs::path const& directory,
+            std::vector<fs::path> const& include_path,
+            std::string const& path_text)
+        {
+            fs::path path = detail::generic_to_path(path_text);
+            std::vector<fs::path> candidates;
+
+            if (!path.has_root_directory() && !path.has_root_name()) {
+                candidates.push_back(directory / path);
+                QUICKBOOK_FOR (fs::path full, include_path) {
+                    full /= path;
+                    candidates.push_back(full);
+                }
+            }
+            else {
+                candidates.push_back(path);
+            }
+
+            return candidates;
+        }
+
+        // Scans quickbook files for includes. The file's quickbook version
+        // isn't known yet, so anything that might be a glob is skipped.
+        // Globbing also uses the directory cache, which isn't thread safe.
+        // The include path is copied, as the global one can be changed
+        // while the prefetch threads are running.
+        struct include_scanner : prefetch_scanner
+        {
+            std::vector<fs::path> include_path;
+
+            explicit include_scanner(std::vector<fs::path> const& paths)
+                : include_path(paths)
+            {
+            }
+
+            void scan(
+                fs::path const& file,
+                quickbook::string_view source,
+                std::vector<std::vector<fs::path> >& result) const
+            {
+                std::string ext = file.extension().generic_string();
+                if (ext != ".qbk" && ext != ".quickbook") return;
+
+                fs::path directory = file.parent_path();
+
+                for (string_iterator it = source.begin(), end = source.end();
+                     (it = std::find(it, end, '[')) != end; ++it) {
+                    std::string path_text = match_include(it, end).to_s();
+                    if (path_text.empty()) continue;
+
+                    try {
+                        if (check_glob(path_text)) continue;
+                    } catch (glob_error&) {
+                        continue;
+                    }
+
+                    result.push_back(
+                        include_candidates(directory, include_path, path_text));
+                }
+            }
+        };
+    }
+
+    void prefetch_includes(quickbook::state& state)
+    {
+        quickbook::string_view source = state.current_file->source();
+        quickbook_path location = state.current_path.parent_path();
+        prefetch_scanner_ptr scanner;
+
+        for (string_iterator it = source.begin(), end = source.end();
+             (it = std::find(it, end, '[')) != end; ++it) {
+            std::string path_text = match_include(it, end).to_s();
+            if (path_text.empty()) continue;
+
+            bool is_glob = false;
+            if (qbk_version_n >= 107u) {
+                try {
+                    is_glob = check_glob(path_text);
+                } catch (glob_error&) {
+                    continue;
+                }
+            }
+
+            if (is_glob) {
+                // Errors are reported when the include is processed.
+                try {
+                    prefetch_match match;
+                    glob_files(glob_location(location), path_text, match);
+                    QUICKBOOK_FOR (fs::path dir, include_path) {
+                        glob_files(
+                            glob_location(dir, 0, fs::path()), path_text,
+                            match);
+                    }
+                } catch (fs::filesystem_error&) {
+                }
+                continue;
+            }
+
+            if (!scanner) scanner.reset(new include_scanner(include_path));
+            prefetch(
+                include_candidates(location.file_path, include_path, path_text),
+                scanner);
+        }
+    }
+
     //
     // quickbook_path
     //
@@ -295,16 +677,16 @@ namespace quickbook
     quickbook_path& quickbook_path::operator/=(quickbook::string_view x)
     {
         fs::path x2 = detail::generic_to_path(x);
-        file_path /= x2;
-        abstract_file_path /= x2;
+        file_path = *file_path / x2;
+        abstract_file_path = *abstract_file_path / x2;
         return *this;
     }
 
     quickbook_path quickbook_path::parent_path() const
     {
         return quickbook_path(
-            file_path.parent_path(), include_path_offset,
-            abstract_file_path.parent_path());
+            file_path->parent_path(), include_path_offset,
+            abstract_file_path->parent_path());
     }
 
     quickbook_path resolve_xinclude_path(
@@ -19,6 +19,7 @@
 #include <string>
 #include <boost/filesystem/path.hpp>
 #include "fwd.hpp"
+#include "path.hpp"
 #include "values.hpp"
 
 namespace quickbook
@@ -47,7 +48,8 @@ namespace quickbook
 
     struct quickbook_path
     {
-        quickbook_path(fs::path const& x, unsigned offset, fs::path const& y)
+        quickbook_path(
+            interned_path const& x, unsigned offset, interned_path const& y)
             : file_path(x), include_path_offset(offset), abstract_file_path(y)
         {
         }
@@ -61,7 +63,7 @@ namespace quickbook
         quickbook_path& operator/=(quickbook::string_view);
 
         // The actual location of the file.
-        fs::path file_path;
+        interned_path file_path;
 
         // The member of the include path that this file is relative to.
         // (1-indexed, 0 == original quickbook file)
@@ -69,7 +71,7 @@ namespace quickbook
 
         // A machine independent representation of the file's
         // path - not unique per-file
-        fs::path abstract_file_path;
+        interned_path abstract_file_path;
     };
 
     std::set<quickbook_path> include_search(
@@ -77,6 +79,15 @@ namespace quickbook
 
     quickbook_path resolve_xinclude_path(
         std::string const&, quickbook::state&, bool is_file = false);
+
+    // Scan the current file for includes and imports, and start loading the
+    // files they refer to in the background.
+    void prefetch_includes(quickbook::state&);
+
+    // Directory listings and compiled globs are cached, this clears them
+    // for when the files might have changed, e.g. between conversions in
+    // 'convert'.
+    void clear_directory_cache();
 }
 
 #endif
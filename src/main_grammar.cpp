@@ -316,6 +316,76 @@ namespace quickbook
         }
     };
 
+    ////////////////////////////////////////////////////////////////////////////
+    // Plain text
+    //
+    // Matches a run of characters that can't start any markup, or a macro, so
+    // that they can be written in one go instead of trying every alternative
+    // in 'common' for each character. Stops at whitespace, as that's where
+    // paragraphs, blocks and phrases are ended.
+
+    struct plain_text_parser : cl::parser<plain_text_parser>
+    {
+        explicit plain_text_parser(quickbook::state& state_) : state(state_)
+        {
+        }
+
+        template <typename ScannerT> struct result
+        {
+            typedef cl::match<> type;
+        };
+
+        template <typename ScannerT>
+        typename result<ScannerT>::type parse(ScannerT const& scan) const
+        {
+            typedef typename ScannerT::iterator_t iterator_t;
+
+            static bool const* const markup = markup_chars();
+
+            iterator_t save(scan.first);
+            std::size_t length = 0;
+
+            for (; !scan.at_end(); ++scan.first, ++length) {
+                char ch = *scan.first;
+
+                if (markup[static_cast<unsigned char>(ch)]) {
+                    // A single quote is only markup when it starts "'''".
+                    if (ch != '\'' || is_escape(scan.first, scan.last)) break;
+                }
+                else if (symbol_may_start_with(state.macro, ch)) {
+                    break;
+                }
+            }
+
+            return length ? scan.create_match(
+                                length, cl::nil_t(), save, scan.first)
+                          : scan.no_match();
+        }
+
+        template <typename Iterator>
+        static bool is_escape(Iterator it, Iterator last)
+        {
+            for (int i = 0; i < 3; ++i, ++it) {
+                if (it == last || *it != '\'') return false;
+            }
+            return true;
+        }
+
+        // Characters which might start markup, including the marks for
+        // simple markup, which also depend on the preceding character.
+        static bool const* markup_chars()
+        {
+            static bool table[256] = {false};
+            char const* chars = "[]`*/_=\\' \t\n\r\f\v";
+            for (char const* it = chars; *it; ++it) {
+                table[static_cast<unsigned char>(*it)] = true;
+            }
+            return table;
+        }
+
+        quickbook::state& state;
+    };
+
     ////////////////////////////////////////////////////////////////////////////
     // Local grammar
 
@@ -330,6 +400,7 @@ namespace quickbook
         phrase_end_action end_phrase(state);
         raw_char_action raw_char(state);
         plain_char_action plain_char(state);
+        plain_text_parser plain_text(state);
         escape_unicode_action escape_unicode(state);
 
         simple_phrase_action simple_markup(state);
@@ -620,7 +691,8 @@ namespace quickbook
             ;
 
         local.common =
-                local.macro
+                plain_text                  [plain_char]
+            |   local.macro
             |   local.element
             |   local.template_
             |   local.break_
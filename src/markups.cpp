@@ -9,24 +9,30 @@
 =============================================================================*/
 
 #include "markups.hpp"
-#include <map>
+#include <cstddef>
 #include <ostream>
 #include "block_tags.hpp"
-#include "for.hpp"
 #include "phrase_tags.hpp"
-#include "quickbook.hpp"
 
 namespace quickbook
 {
     namespace detail
     {
-        std::map<value::tag_type, markup> markups;
-
-        void initialise_markups()
+        namespace
         {
-            markup init_markups[] = {
-                {block_tags::paragraph, "<para>\n", "</para>\n"},
-                {block_tags::paragraph_in_list, "<simpara>\n", "</simpara>\n"},
+            // Indexed by tag, so every tag in 'block_tags' and
+            // 'phrase_tags' has an entry, in order. Tags without any
+            // markup have null strings.
+            constexpr markup block_markups[] = {
+                {block_tags::begin_section, 0, 0},
+                {block_tags::end_section, 0, 0},
+                {block_tags::generic_heading, 0, 0},
+                {block_tags::heading1, 0, 0},
+                {block_tags::heading2, 0, 0},
+                {block_tags::heading3, 0, 0},
+                {block_tags::heading4, 0, 0},
+                {block_tags::heading5, 0, 0},
+                {block_tags::heading6, 0, 0},
                 {block_tags::blurb, "<sidebar role=\"blurb\">\n",
                  "</sidebar>\n"},
                 {block_tags::blockquote, "<blockquote>", "</blockquote>"},
@@ -38,12 +44,25 @@ namespace quickbook
                 {block_tags::note, "<note>", "</note>"},
                 {block_tags::tip, "<tip>", "</tip>"},
                 {block_tags::block, "", ""},
+                {block_tags::macro_definition, 0, 0},
+                {block_tags::template_definition, 0, 0},
+                {block_tags::variable_list, 0, 0},
+                {block_tags::table, 0, 0},
+                {block_tags::xinclude, 0, 0},
+                {block_tags::import, 0, 0},
+                {block_tags::include, 0, 0},
+                {block_tags::paragraph, "<para>\n", "</para>\n"},
+                {block_tags::paragraph_in_list, "<simpara>\n", "</simpara>\n"},
                 {block_tags::ordered_list, "<orderedlist>", "</orderedlist>"},
                 {block_tags::itemized_list, "<itemizedlist>",
                  "</itemizedlist>"},
-                {block_tags::hr, "<para/>", 0},
+                {block_tags::hr, "<para/>", 0}};
+
+            constexpr markup phrase_markups[] = {
+                {phrase_tags::image, 0, 0},
                 {phrase_tags::url, "<ulink url=\"", "</ulink>"},
                 {phrase_tags::link, "<link linkend=\"", "</link>"},
+                {phrase_tags::anchor, 0, 0},
                 {phrase_tags::funcref, "<functionname alt=\"",
                  "</functionname>"},
                 {phrase_tags::classref, "<classname alt=\"", "</classname>"},
@@ -63,16 +82,42 @@ namespace quickbook
                  "<emphasis role=\"strikethrough\">", "</emphasis>"},
                 {phrase_tags::quote, "<quote>", "</quote>"},
                 {phrase_tags::replaceable, "<replaceable>", "</replaceable>"},
+                {phrase_tags::footnote, 0, 0},
                 {phrase_tags::escape, "<!--quickbook-escape-prefix-->",
                  "<!--quickbook-escape-postfix-->"},
-                {phrase_tags::break_mark, "<sbr/>\n", 0}};
+                {phrase_tags::break_mark, "<sbr/>\n", 0},
+                {phrase_tags::role, 0, 0}};
 
-            QUICKBOOK_FOR (markup m, init_markups) {
-                markups[m.tag] = m;
+            template <std::size_t N>
+            constexpr bool is_dense_table(
+                markup const (&table)[N], int begin, int end, std::size_t i = 0)
+            {
+                return i >= N ? static_cast<int>(N) == end - begin
+                              : table[i].tag == begin + static_cast<int>(i) &&
+                                    is_dense_table(table, begin, end, i + 1);
             }
+
+            static_assert(
+                is_dense_table(
+                    block_markups, block_tags::begin_section,
+                    block_tags::end_index),
+                "block_markups doesn't match block_tags");
+            static_assert(
+                is_dense_table(
+                    phrase_markups, phrase_tags::image, phrase_tags::end_index),
+                "phrase_markups doesn't match phrase_tags");
+
+            constexpr markup no_markup = {0, 0, 0};
         }
 
-        markup const& get_markup(value::tag_type t) { return markups[t]; }
+        markup const& get_markup(value::tag_type t)
+        {
+            return block_tags::is_tag(t)
+                       ? block_markups[t - block_tags::begin_section]
+                       : phrase_tags::is_tag(t)
+                             ? phrase_markups[t - phrase_tags::image]
+                             : no_markup;
+        }
 
         std::ostream& operator<<(std::ostream& out, markup const& m)
         {
@@ -0,0 +1,91 @@
+/*=============================================================================
+    Copyright (c) 2002 2004 2006 Joel de Guzman
+    Copyright (c) 2004 Eric Niebler
+    http://spirit.sourceforge.net/
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+// The global settings and the file parser, kept apart from the command line
+// driver so that other programs (such as the benchmarks) can link against
+// the rest of quickbook.
+
+#include <cassert>
+#include "actions.hpp"
+#include "files.hpp"
+#include "for.hpp"
+#include "grammar.hpp"
+#include "include_paths.hpp"
+#include "quickbook.hpp"
+#include "state.hpp"
+#include "stream.hpp"
+
+namespace quickbook
+{
+    namespace cl = boost::spirit::classic;
+    namespace fs = boost::filesystem;
+
+    tm* current_time;    // the current time
+    tm* current_gm_time; // the current UTC time
+    bool debug_mode;     // for quickbook developers only
+    bool self_linked_headers;
+    std::vector<fs::path> include_path;
+    std::vector<std::string> preset_defines;
+    fs::path image_location;
+
+    void set_macros(quickbook::state& state)
+    {
+        QUICKBOOK_FOR (quickbook::string_view val, preset_defines) {
+            parse_iterator first(val.begin());
+            parse_iterator last(val.end());
+
+            cl::parse_info<parse_iterator> info =
+                cl::parse(first, last, state.grammar().command_line_macro);
+
+            if (!info.full) {
+                detail::outerr() << "Error parsing command line definition: '"
+                                 << val << "'" << std::endl;
+                ++state.error_count;
+            }
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //
+    //  Parse a file
+    //
+    ///////////////////////////////////////////////////////////////////////////
+    void parse_file(
+        quickbook::state& state, value include_doc_id, bool nested_file)
+    {
+        parse_iterator first(state.current_file->source().begin());
+        parse_iterator last(state.current_file->source().end());
+
+        cl::parse_info<parse_iterator> info =
+            cl::parse(first, last, state.grammar().doc_info);
+        assert(info.hit);
+
+        if (!state.error_count) {
+            std::string doc_type =
+                pre(state, info.stop, include_doc_id, nested_file);
+
+            prefetch_includes(state);
+
+            info = cl::parse(
+                info.hit ? info.stop : first, last,
+                state.grammar().block_start);
+
+            post(state, doc_type);
+
+            if (!info.full) {
+                file_position const& pos =
+                    state.current_file->position_of(info.stop.base());
+                detail::outerr(state.current_file->path, pos.line)
+                    << "Syntax Error near column " << pos.column << ".\n";
+                ++state.error_count;
+            }
+        }
+    }
+}
@@ -10,9 +10,11 @@
 =============================================================================*/
 
 #include "path.hpp"
+#include <algorithm>
 #include <cassert>
 #include <boost/filesystem/operations.hpp>
 #include <boost/range/algorithm/replace.hpp>
+#include <boost/unordered_set.hpp>
 #include "for.hpp"
 #include "glob.hpp"
 #include "include_paths.hpp"
@@ -114,6 +116,159 @@ namespace quickbook
         return result;
     }
 
+    void split_path::append(quickbook::string_view path)
+    {
+        string_iterator it = path.begin(), end = path.end();
+
+        while (it != end) {
+            string_iterator part_end = std::find(it, end, '/');
+            quickbook::string_view part(it, part_end - it);
+
+            if (part.empty() || part == ".") {
+            }
+            else if (part == "..") {
+                if (!parts.empty()) parts.pop_back();
+            }
+            else {
+                parts.push_back(part.to_s());
+            }
+
+            it = part_end == end ? end : part_end + 1;
+        }
+    }
+
+    split_path split_absolute_path(fs::path const& path)
+    {
+        fs::path absolute_path = fs::absolute(path);
+
+        split_path result;
+        result.root = detail::path_to_generic(absolute_path.root_path());
+        QUICKBOOK_FOR (
+            fs::path const& part,
+            remove_dots_from_path(absolute_path.relative_path())) {
+            result.parts.push_back(detail::path_to_generic(part));
+        }
+        return result;
+    }
+
+    split_path split_absolute_path(
+        fs::path const& path, split_path const& base)
+    {
+        split_path result = split_absolute_path(path);
+
+        fs::path base_tmp = detail::generic_to_path(base.root),
+                 path_tmp = detail::generic_to_path(result.root);
+
+        if (result.root != base.root) {
+            if (!fs::equivalent(base_tmp, path_tmp)) return result;
+            result.root = base.root;
+        }
+
+        // Same check as in path_difference.
+        for (std::size_t i = 0;
+             i < base.parts.size() && i < result.parts.size(); ++i) {
+            base_tmp /= detail::generic_to_path(base.parts[i]);
+            path_tmp /= detail::generic_to_path(result.parts[i]);
+            if (base.parts[i] != result.parts[i]) {
+                if (!fs::exists(base_tmp) || !fs::exists(path_tmp) ||
+                    !fs::equivalent(base_tmp, path_tmp)) {
+                    break;
+                }
+                result.parts[i] = base.parts[i];
+            }
+        }
+
+        return result;
+    }
+
+    std::string lexical_path_difference(
+        split_path const& base, split_path const& path)
+    {
+        // If they have different roots then there's no relative path so
+        // just build an absolute path.
+        std::string result;
+        std::vector<std::string>::const_iterator path_it = path.parts.begin();
+
+        if (base.root != path.root) {
+            result = path.root;
+        }
+        else {
+            std::vector<std::string>::const_iterator base_it =
+                base.parts.begin();
+
+            while (base_it != base.parts.end() &&
+                   path_it != path.parts.end() && *base_it == *path_it) {
+                ++base_it;
+                ++path_it;
+            }
+
+            if (base_it == base.parts.end() && path_it == path.parts.end()) {
+                return ".";
+            }
+
+            for (; base_it != base.parts.end(); ++base_it) {
+                result += "../";
+            }
+        }
+
+        for (; path_it != path.parts.end(); ++path_it) {
+            result += *path_it;
+            result += '/';
+        }
+
+        // Remove the trailing slash.
+        if (!result.empty() && result != path.root) {
+            result.resize(result.size() - 1);
+        }
+
+        return result;
+    }
+
+    namespace
+    {
+        typedef boost::unordered_set<fs::path> interned_path_table;
+
+        interned_path_table& interned_paths()
+        {
+            static interned_path_table table;
+            return table;
+        }
+
+        // Elements in an unordered_set aren't moved when it's rehashed, so
+        // pointers to them remain valid.
+        fs::path const* intern_path(fs::path const& path)
+        {
+            return &*interned_paths().insert(path).first;
+        }
+    }
+
+    interned_path::interned_path()
+    {
+        static fs::path const* empty = intern_path(fs::path());
+        path_ = empty;
+    }
+
+    interned_path::interned_path(fs::path const& path)
+        : path_(intern_path(path))
+    {
+    }
+
+    // The empty path is kept, as it's used by every default constructed
+    // 'interned_path'.
+    void clear_interned_paths()
+    {
+        interned_path_table& table = interned_paths();
+        for (interned_path_table::iterator it = table.begin();
+             it != table.end();) {
+            if (it->empty()) {
+                ++it;
+            }
+            else {
+                it = table.erase(it);
+            }
+        }
+    }
+
     // Convert a Boost.Filesystem path to a URL.
     //
     // I'm really not sure about this, as the meaning of root_name and
@@ -12,6 +12,8 @@
 #if !defined(BOOST_QUICKBOOK_DETAIL_PATH_HPP)
 #define BOOST_QUICKBOOK_DETAIL_PATH_HPP
 
+#include <string>
+#include <vector>
 #include <boost/filesystem/path.hpp>
 #include "native_text.hpp"
 
@@ -23,10 +25,82 @@ namespace quickbook
     fs::path path_difference(
         fs::path const& base, fs::path const& path, bool is_file = false);
 
+    // An absolute path, split into generic parts with '.' and '..' removed,
+    // for working out relative paths without using the filesystem.
+    struct split_path
+    {
+        std::string root; // Generic root path, e.g. "/" or "C:/"
+        std::vector<std::string> parts;
+
+        // Append a generic relative path.
+        void append(quickbook::string_view);
+    };
+
+    // Only uses the filesystem to make the path absolute.
+    split_path split_absolute_path(fs::path const&);
+
+    // As above, but if the start of the path is equivalent to the start of
+    // 'base' on the filesystem (e.g. through a symbolic link) then it's
+    // rewritten to match 'base', so that later lexical comparisons will
+    // treat them as the same.
+    split_path split_absolute_path(fs::path const&, split_path const& base);
+
+    // The relative path from 'base' to 'path' as a generic string. Unlike
+    // 'path_difference', this doesn't check if differing parts of the paths
+    // are equivalent on the filesystem, so it's only suitable for paths that
+    // are known to be spelt consistently.
+    std::string lexical_path_difference(
+        split_path const& base, split_path const& path);
+
     // Convert a Boost.Filesystem path to a URL.
     std::string file_path_to_url(fs::path const&);
     std::string dir_path_to_url(fs::path const&);
 
+    // A path stored in a global table, so that copies share the same
+    // object. This makes copying and equality checks cheap, which is useful
+    // for paths that are saved and restored a lot, such as the current path
+    // in 'state'. Interned paths are kept until 'clear_interned_paths' is
+    // called, so this should only be used for paths that quickbook actually
+    // visits.
+    class interned_path
+    {
+        fs::path const* path_;
+
+      public:
+        // An empty path.
+        interned_path();
+
+        interned_path(fs::path const&);
+
+        fs::path const& get() const { return *path_; }
+        operator fs::path const&() const { return *path_; }
+        fs::path const& operator*() const { return *path_; }
+        fs::path const* operator->() const { return path_; }
+
+        bool empty() const { return path_->empty(); }
+
+        friend bool operator==(interned_path const& x, interned_path const& y)
+        {
+            return x.path_ == y.path_;
+        }
+
+        friend bool operator!=(interned_path const& x, interned_path const& y)
+        {
+            return x.path_ != y.path_;
+        }
+
+        // Ordered by the path, not by where they're stored.
+        friend bool operator<(interned_path const& x, interned_path const& y)
+        {
+            return x.path_ != y.path_ && *x.path_ < *y.path_;
+        }
+    };
+
+    // Free the interned paths. Any 'interned_path' other than an empty one
+    // is left dangling, so this is only called between conversions, when
+    // there's no 'state' alive.
+    void clear_interned_paths();
+
     namespace detail
     {
 // 'generic':   Paths in quickbook source and the generated boostbook.
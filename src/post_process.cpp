@@ -7,13 +7,15 @@
     http://www.boost.org/LICENSE_1_0.txt)
 =============================================================================*/
 #include "post_process.hpp"
+#include <algorithm>
 #include <cctype>
-#include <set>
 #include <stack>
+#include <boost/algorithm/string/predicate.hpp>
 #include <boost/bind/bind.hpp>
 #include <boost/spirit/include/classic_core.hpp>
 #include <boost/spirit/include/phoenix1_operators.hpp>
 #include <boost/spirit/include/phoenix1_primitives.hpp>
+#include "pretty_printer.hpp"
 
 using namespace boost::placeholders;
 
@@ -23,216 +25,51 @@ namespace quickbook
     namespace ph = phoenix;
     typedef std::string::const_iterator iter_type;
 
-    struct pretty_printer
-    {
-        pretty_printer(std::string& out_, int& current_indent_, int linewidth_)
-            : prev(0)
-            , out(out_)
-            , current_indent(current_indent_)
-            , column(0)
-            , in_string(false)
-            , linewidth(linewidth_)
-        {
-        }
-
-        void indent()
-        {
-            BOOST_ASSERT(current_indent >= 0); // this should not happen!
-            for (int i = 0; i < current_indent; ++i)
-                out += ' ';
-            column = current_indent;
-        }
-
-        void trim_spaces()
-        {
-            out.erase(out.find_last_not_of(' ') + 1); // trim trailing spaces
-        }
-
-        void break_line()
-        {
-            trim_spaces();
-            out += '\n';
-            indent();
-        }
-
-        bool line_is_empty() const
-        {
-            for (iter_type i = out.end() - (column - current_indent);
-                 i != out.end(); ++i) {
-                if (*i != ' ') return false;
-            }
-            return true;
-        }
-
-        void align_indent()
-        {
-            // make sure we are at the proper indent position
-            if (column != current_indent) {
-                if (column > current_indent) {
-                    if (line_is_empty()) {
-                        // trim just enough trailing spaces down to
-                        // current_indent position
-                        out.erase(
-                            out.end() - (column - current_indent), out.end());
-                        column = current_indent;
-                    }
-                    else {
-                        // nope, line is not empty. do a hard CR
-                        break_line();
-                    }
-                }
-                else {
-                    // will this happen? (i.e. column <= current_indent)
-                    while (column != current_indent) {
-                        out += ' ';
-                        ++column;
-                    }
-                }
-            }
-        }
-
-        void print(char ch)
-        {
-            // Print a char. Attempt to break the line if we are exceeding
-            // the target linewidth. The linewidth is not an absolute limit.
-            // There are many cases where a line will exceed the linewidth
-            // and there is no way to properly break the line. Preformatted
-            // code that exceeds the linewidth are examples. We cannot break
-            // preformatted code. We shall not attempt to be very strict with
-            // line breaking. What's more important is to have a reproducable
-            // output (i.e. processing two logically equivalent xml files
-            // results in two lexically equivalent xml files). *** pretty
-            // formatting is a secondary goal ***
-
-            // Strings will occur only in tag attributes. Normal content
-            // will have &quot; instead. We shall deal only with tag
-            // attributes here.
-            if (ch == '"') in_string = !in_string; // don't break strings!
-
-            if (!in_string && std::isspace(static_cast<unsigned char>(ch))) {
-                // we can break spaces if they are not inside strings
-                if (!std::isspace(static_cast<unsigned char>(prev))) {
-                    if (column >= linewidth) {
-                        break_line();
-                        if (column == 0 && ch == ' ') {
-                            ++column;
-                            out += ' ';
-                        }
-                    }
-                    else {
-                        ++column;
-                        out += ' ';
-                    }
-                }
-            }
-            else {
-                // we can break tag boundaries and stuff after
-                // delimiters if they are not inside strings
-                // and *only-if* the preceding char is a space
-                if (!in_string && column >= linewidth &&
-                    (ch == '<' &&
-                     std::isspace(static_cast<unsigned char>(prev))))
-                    break_line();
-                out += ch;
-                ++column;
-            }
-
-            prev = ch;
-        }
-
-        void print(iter_type f, iter_type l)
-        {
-            for (iter_type i = f; i != l; ++i)
-                print(*i);
-        }
-
-        void print_tag(iter_type f, iter_type l, bool is_flow_tag)
-        {
-            if (is_flow_tag) {
-                print(f, l);
-            }
-            else {
-                // This is not a flow tag, so, we're going to do a
-                // carriage return anyway. Let us remove extra right
-                // spaces.
-                std::string str(f, l);
-                BOOST_ASSERT(f != l); // this should not happen
-                iter_type i = str.end();
-                while (i != str.begin() &&
-                       std::isspace(static_cast<unsigned char>(*(i - 1))))
-                    --i;
-                print(str.begin(), i);
-            }
-        }
-
-        char prev;
-        std::string& out;
-        int& current_indent;
-        int column;
-        bool in_string;
-        int linewidth;
-
-      private:
-        pretty_printer& operator=(pretty_printer const&);
-    };
-
-    char const* html_block_tags_[] = {
-        "div",   "p",    "blockquote", "address", "h1",       "h2",   "h3",
-        "h4",    "h5",   "h6",         "ul",      "ol",       "li",   "dl",
-        "dt",    "dd",   "table",      "tr",      "th",       "td",   "tbody",
-        "thead", "form", "fieldset",   "hr",      "noscript", "html", "body"};
-
-    char const* block_tags_[] = {
-        "author",      "blockquote",    "bridgehead",   "callout",
-        "calloutlist", "caution",       "copyright",    "entry",
-        "important",   "informaltable", "itemizedlist", "legalnotice",
-        "listitem",    "note",          "orderedlist",  "para",
-        "row",         "section",       "simpara",      "table",
-        "tbody",       "textobject",    "tgroup",       "thead",
-        "tip",         "variablelist",  "varlistentry", "warning",
-        "xml",         "xi:include"};
-
-    char const* doc_types_[] = {"book",     "article",   "library", "chapter",
-                                "part",     "appendix",  "preface", "qandadiv",
-                                "qandaset", "reference", "set"};
+    // The boostbook block tags, including each document type with its
+    // 'info' and 'purpose' elements.
+    constexpr detail::static_string block_tags_[] = {
+        "appendix",         "appendixinfo", "appendixpurpose",
+        "article",          "articleinfo",  "articlepurpose",
+        "author",           "blockquote",   "book",
+        "bookinfo",         "bookpurpose",  "bridgehead",
+        "callout",          "calloutlist",  "caution",
+        "chapter",          "chapterinfo",  "chapterpurpose",
+        "copyright",        "entry",        "important",
+        "informaltable",    "itemizedlist", "legalnotice",
+        "library",          "libraryinfo",  "librarypurpose",
+        "listitem",         "note",         "orderedlist",
+        "para",             "part",         "partinfo",
+        "partpurpose",      "preface",      "prefaceinfo",
+        "prefacepurpose",   "qandadiv",     "qandadivinfo",
+        "qandadivpurpose",  "qandaset",     "qandasetinfo",
+        "qandasetpurpose",  "reference",    "referenceinfo",
+        "referencepurpose", "row",          "section",
+        "set",              "setinfo",      "setpurpose",
+        "simpara",          "table",        "tbody",
+        "textobject",       "tgroup",       "thead",
+        "tip",              "variablelist", "varlistentry",
+        "warning",          "xi:include",   "xml"};
+
+    static_assert(
+        detail::is_sorted_table(block_tags_), "block_tags_ isn't sorted");
 
     struct tidy_compiler
     {
         tidy_compiler(std::string& out_, int linewidth_, bool is_html)
-            : out(out_)
+            : block_tags(is_html ? detail::string_table(html_block_tags_)
+                                 : detail::string_table(block_tags_))
+            , out(out_)
             , current_indent(0)
             , printer(out_, current_indent, linewidth_)
         {
-            if (is_html) {
-                static std::size_t const n_block_tags =
-                    sizeof(html_block_tags_) / sizeof(char const*);
-                for (std::size_t i = 0; i != n_block_tags; ++i) {
-                    block_tags.insert(html_block_tags_[i]);
-                }
-            }
-            else {
-                static std::size_t const n_block_tags =
-                    sizeof(block_tags_) / sizeof(char const*);
-                for (std::size_t i = 0; i != n_block_tags; ++i) {
-                    block_tags.insert(block_tags_[i]);
-                }
-
-                static std::size_t const n_doc_types =
-                    sizeof(doc_types_) / sizeof(char const*);
-                for (std::size_t i = 0; i != n_doc_types; ++i) {
-                    block_tags.insert(doc_types_[i]);
-                    block_tags.insert(doc_types_[i] + std::string("info"));
-                    block_tags.insert(doc_types_[i] + std::string("purpose"));
-                }
-            }
         }
 
         bool is_flow_tag(std::string const& tag)
         {
-            return block_tags.find(tag) == block_tags.end();
+            return !block_tags.contains(tag);
         }
 
-        std::set<std::string> block_tags;
+        detail::string_table block_tags;
         std::stack<std::string> tags;
         std::string& out;
         int current_indent;
@@ -331,53 +168,12 @@ namespace quickbook
 
         void do_escape(iter_type f, iter_type l) const
         {
-            while (f != l && std::isspace(*f)) {
-                ++f;
-            }
-            while (f != l && std::isspace(*(l - 1))) {
-                --l;
-            }
-            for (iter_type i = f; i != l; ++i) {
-                state.out += *i;
-            }
+            state.printer.print_escape(f, l);
         }
 
         void do_code(iter_type f, iter_type l) const
         {
-            state.printer.trim_spaces();
-            if (state.out[state.out.size() - 1] != '\n') state.out += '\n';
-
-            // trim trailing space from after closing tag
-            while (f != l && std::isspace(*(l - 1))) {
-                --l;
-            }
-
-            // print the string taking care of line
-            // ending CR/LF platform issues
-            for (iter_type i = f; i != l;) {
-                if (*i == '\n') {
-                    state.printer.trim_spaces();
-                    state.out += '\n';
-                    ++i;
-                    if (i != l && *i == '\r') {
-                        ++i;
-                    }
-                }
-                else if (*i == '\r') {
-                    state.printer.trim_spaces();
-                    state.out += '\n';
-                    ++i;
-                    if (i != l && *i == '\n') {
-                        ++i;
-                    }
-                }
-                else {
-                    state.out += *i;
-                    ++i;
-                }
-            }
-            state.out += '\n';
-            state.printer.indent();
+            state.printer.print_code(f, l);
         }
 
         void do_tag(iter_type f, iter_type l) const
@@ -451,4 +247,257 @@ namespace quickbook
             throw quickbook::post_process_failure("Post Processing Failed.");
         }
     }
+
+    //
+    // tidy_printer
+    //
+
+    namespace
+    {
+        quickbook::string_view const escape_prefix =
+            "<!--quickbook-escape-prefix-->";
+        quickbook::string_view const escape_postfix =
+            "<!--quickbook-escape-postfix-->";
+
+        bool is_space(char c)
+        {
+            return std::isspace(static_cast<unsigned char>(c)) != 0;
+        }
+
+        bool is_tag_char(char c)
+        {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_' ||
+                   c == ':';
+        }
+
+        // True if 'x' is the start of 'y', but more text is needed to tell
+        // if it matches.
+        bool is_partial_match(
+            quickbook::string_view x, quickbook::string_view y)
+        {
+            return x.size() < y.size() && boost::starts_with(y, x);
+        }
+    }
+
+    tidy_printer::tidy_printer(
+        std::string& out, int indent, int linewidth, bool is_html_)
+        : is_html(is_html_)
+        , indent_width(indent == -1 ? 2 : indent)
+        , current_indent(0)
+        , printer(out, current_indent, linewidth == -1 ? 80 : linewidth)
+        , block_tags(
+              is_html ? detail::string_table(html_block_tags_)
+                      : detail::string_table(block_tags_))
+        , tags()
+        , current_tag_is_flow(true)
+        , whitespace(skip_whitespace)
+        , in_tag(false)
+        , tag_is_flow(false)
+        , pending()
+        , searched(0)
+        , failed(false)
+    {
+    }
+
+    void tidy_printer::write(quickbook::string_view x)
+    {
+        if (in_tag) {
+            printer.print(x.begin(), x.end());
+        }
+        else if (pending.empty()) {
+            std::size_t n = scan(x, 0);
+            pending.assign(x.begin() + n, x.end());
+        }
+        else {
+            pending.append(x.begin(), x.end());
+            pending.erase(0, scan(pending, searched));
+        }
+        searched = pending.size();
+    }
+
+    bool tidy_printer::finish()
+    {
+        bool success = !failed && !in_tag;
+        if (!pending.empty()) {
+            success = false;
+            printer.print(pending.begin(), pending.end());
+            pending.clear();
+        }
+        return success;
+    }
+
+    std::size_t tidy_printer::complete_size() const
+    {
+        // The pretty printer can look back over the current line, or as
+        // far as its column count, which isn't updated by escapes.
+        std::string const& out = printer.out;
+        std::size_t line_start = out.rfind('\n');
+        std::size_t keep = std::max<std::size_t>(
+            line_start == std::string::npos ? out.size()
+                                            : out.size() - line_start,
+            static_cast<std::size_t>(std::max(printer.column, 0)) + 1);
+        return out.size() > keep ? out.size() - keep : 0;
+    }
+
+    // Returns the length of the text which was processed, the rest is the
+    // start of some markup.
+    std::size_t tidy_printer::scan(
+        quickbook::string_view x, std::size_t already_searched)
+    {
+        string_iterator it = x.begin(), end = x.end();
+
+        while (it != end) {
+            if (whitespace != print_whitespace) {
+                for (; it != end && is_space(*it); ++it) {
+                    if (whitespace == raw_whitespace) {
+                        printer.out += *it;
+                    }
+                }
+                if (it == end) {
+                    break;
+                }
+            }
+
+            if (*it == '<') {
+                std::size_t n = scan_markup(
+                    quickbook::string_view(it, end - it),
+                    it == x.begin() ? already_searched : 0);
+                if (!n) {
+                    break;
+                }
+                it += n;
+            }
+            else {
+                string_iterator content_end = std::find(it, end, '<');
+                printer.print(it, content_end);
+                whitespace = print_whitespace;
+                it = content_end;
+            }
+        }
+
+        return it - x.begin();
+    }
+
+    // Process the markup at the start of 'x', returns its length, or 0 if
+    // it isn't complete.
+    std::size_t tidy_printer::scan_markup(
+        quickbook::string_view x, std::size_t already_searched)
+    {
+        quickbook::string_view const code_start =
+            is_html ? "<pre" : "<programlisting>";
+        quickbook::string_view const code_end =
+            is_html ? "</pre>" : "</programlisting>";
+
+        if (is_partial_match(x, escape_prefix) ||
+            is_partial_match(x, code_start)) {
+            return 0;
+        }
+
+        // Where to start searching for the end of the markup.
+        std::size_t from = already_searched > escape_postfix.size()
+                               ? already_searched - escape_postfix.size()
+                               : 0;
+
+        if (boost::starts_with(x, escape_prefix)) {
+            std::size_t end =
+                x.find(escape_postfix, std::max(escape_prefix.size(), from));
+            if (end == quickbook::string_view::npos) {
+                return 0;
+            }
+            printer.print_escape(
+                x.begin() + escape_prefix.size(), x.begin() + end);
+            whitespace = raw_whitespace;
+            return end + escape_postfix.size();
+        }
+
+        if (boost::starts_with(x, code_start)) {
+            // The html code tag can have attributes.
+            std::size_t start = is_html ? x.find('>', code_start.size())
+                                        : code_start.size() - 1;
+            std::size_t end =
+                start == quickbook::string_view::npos
+                    ? start
+                    : x.find(code_end, std::max(start + 1, from));
+            if (end == quickbook::string_view::npos) {
+                return 0;
+            }
+            end += code_end.size();
+            printer.print_code(x.begin(), x.begin() + end);
+            whitespace = skip_whitespace;
+            return end;
+        }
+
+        if (boost::starts_with(x, "<!--")) {
+            std::size_t end = x.find("-->", std::max<std::size_t>(4, from));
+            if (end == quickbook::string_view::npos) {
+                return 0;
+            }
+            end += 3;
+            print_markup(quickbook::string_view(x.data(), end), false);
+            return end;
+        }
+
+        if (x.size() < 2) {
+            return 0;
+        }
+
+        bool is_end_tag = x[1] == '/';
+        bool is_instruction = x[1] == '?';
+        std::size_t name_start =
+            is_end_tag || is_instruction || x[1] == '!' ? 2 : 1;
+        std::size_t name_end = name_start;
+        while (name_end < x.size() && is_tag_char(x[name_end])) {
+            ++name_end;
+        }
+        if (name_end == x.size()) {
+            return 0;
+        }
+
+        std::size_t end = x.find(is_instruction ? '?' : '>', name_end);
+        if (end == quickbook::string_view::npos ||
+            (is_instruction && end + 1 == x.size())) {
+            return 0;
+        }
+
+        if ((name_end == name_start && !is_end_tag) ||
+            (is_end_tag && end == name_start) ||
+            (is_instruction && x[end + 1] != '>')) {
+            // Not valid markup, so 'post_process' would fail.
+            failed = true;
+            printer.print('<');
+            whitespace = print_whitespace;
+            return 1;
+        }
+
+        end += is_instruction ? 2 : 1;
+        if (!is_end_tag) {
+            current_tag_is_flow = is_flow_tag(quickbook::string_view(
+                x.data() + name_start, name_end - name_start));
+        }
+        print_markup(
+            quickbook::string_view(x.data(), end),
+            !is_end_tag && name_start == 1 && x[end - 2] != '/');
+        return end;
+    }
+
+    void tidy_printer::print_markup(
+        quickbook::string_view x, bool is_start_tag)
+    {
+        if (x[1] == '/') {
+            bool flow = begin_close_tag();
+            printer.print(x.begin(), x.end());
+            end_empty_tag(flow);
+        }
+        else {
+            bool flow = current_tag_is_flow;
+            begin_tag(flow);
+            printer.print(x.begin(), x.end());
+            if (is_start_tag) {
+                end_open_tag(flow);
+            }
+            else {
+                end_empty_tag(flow);
+            }
+        }
+    }
 }
@@ -0,0 +1,354 @@
+/*=============================================================================
+    Copyright (c) 2005 2006 Joel de Guzman
+    http://spirit.sourceforge.net/
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+// The output side of 'post_process', which indents markup and breaks long
+// lines. It's also used by 'html_printer' to format html as it's
+// generated.
+
+#if !defined(BOOST_QUICKBOOK_PRETTY_PRINTER_HPP)
+#define BOOST_QUICKBOOK_PRETTY_PRINTER_HPP
+
+#include <cctype>
+#include <string>
+#include <vector>
+#include <boost/assert.hpp>
+#include "string_table.hpp"
+#include "string_view.hpp"
+
+namespace quickbook
+{
+    struct pretty_printer
+    {
+        pretty_printer(std::string& out_, int& current_indent_, int linewidth_)
+            : prev(0)
+            , out(out_)
+            , current_indent(current_indent_)
+            , column(0)
+            , in_string(false)
+            , linewidth(linewidth_)
+        {
+        }
+
+        void indent()
+        {
+            BOOST_ASSERT(current_indent >= 0); // this should not happen!
+            for (int i = 0; i < current_indent; ++i)
+                out += ' ';
+            column = current_indent;
+        }
+
+        void trim_spaces()
+        {
+            out.erase(out.find_last_not_of(' ') + 1); // trim trailing spaces
+        }
+
+        void break_line()
+        {
+            trim_spaces();
+            out += '\n';
+            indent();
+        }
+
+        bool line_is_empty() const
+        {
+            for (std::string::const_iterator i =
+                     out.end() - (column - current_indent);
+                 i != out.end(); ++i) {
+                if (*i != ' ') return false;
+            }
+            return true;
+        }
+
+        void align_indent()
+        {
+            // make sure we are at the proper indent position
+            if (column != current_indent) {
+                if (column > current_indent) {
+                    if (line_is_empty()) {
+                        // trim just enough trailing spaces down to
+                        // current_indent position
+                        out.erase(
+                            out.end() - (column - current_indent), out.end());
+                        column = current_indent;
+                    }
+                    else {
+                        // nope, line is not empty. do a hard CR
+                        break_line();
+                    }
+                }
+                else {
+                    // will this happen? (i.e. column <= current_indent)
+                    while (column != current_indent) {
+                        out += ' ';
+                        ++column;
+                    }
+                }
+            }
+        }
+
+        void print(char ch)
+        {
+            // Print a char. Attempt to break the line if we are exceeding
+            // the target linewidth. The linewidth is not an absolute limit.
+            // There are many cases where a line will exceed the linewidth
+            // and there is no way to properly break the line. Preformatted
+            // code that exceeds the linewidth are examples. We cannot break
+            // preformatted code. We shall not attempt to be very strict with
+            // line breaking. What's more important is to have a reproducable
+            // output (i.e. processing two logically equivalent xml files
+            // results in two lexically equivalent xml files). *** pretty
+            // formatting is a secondary goal ***
+
+            // Strings will occur only in tag attributes. Normal content
+            // will have &quot; instead. We shall deal only with tag
+            // attributes here.
+            if (ch == '"') in_string = !in_string; // don't break strings!
+
+            if (!in_string && std::isspace(static_cast<unsigned char>(ch))) {
+                // we can break spaces if they are not inside strings
+                if (!std::isspace(static_cast<unsigned char>(prev))) {
+                    if (column >= linewidth) {
+                        break_line();
+                        if (column == 0 && ch == ' ') {
+                            ++column;
+                            out += ' ';
+                        }
+                    }
+                    else {
+                        ++column;
+                        out += ' ';
+                    }
+                }
+            }
+            else {
+                // we can break tag boundaries and stuff after
+                // delimiters if they are not inside strings
+                // and *only-if* the preceding char is a space
+                if (!in_string && column >= linewidth &&
+                    (ch == '<' &&
+                     std::isspace(static_cast<unsigned char>(prev))))
+                    break_line();
+                out += ch;
+                ++column;
+            }
+
+            prev = ch;
+        }
+
+        template <typename Iterator> void print(Iterator f, Iterator l)
+        {
+            for (Iterator i = f; i != l; ++i)
+                print(*i);
+        }
+
+        template <typename Iterator>
+        void print_tag(Iterator f, Iterator l, bool is_flow_tag)
+        {
+            if (is_flow_tag) {
+                print(f, l);
+            }
+            else {
+                // This is not a flow tag, so, we're going to do a
+                // carriage return anyway. Let us remove extra right
+                // spaces.
+                std::string const str(f, l);
+                BOOST_ASSERT(f != l); // this should not happen
+                std::string::const_iterator i = str.end();
+                while (i != str.begin() &&
+                       std::isspace(static_cast<unsigned char>(*(i - 1))))
+                    --i;
+                print(str.begin(), i);
+            }
+        }
+
+        // Preformatted code is written as is, on its own lines, apart from
+        // normalising line endings.
+        template <typename Iterator> void print_code(Iterator f, Iterator l)
+        {
+            trim_spaces();
+            if (out[out.size() - 1] != '\n') out += '\n';
+
+            // trim trailing space from after closing tag
+            while (f != l && std::isspace(*(l - 1))) {
+                --l;
+            }
+
+            // print the string taking care of line
+            // ending CR/LF platform issues
+            for (Iterator i = f; i != l;) {
+                if (*i == '\n') {
+                    trim_spaces();
+                    out += '\n';
+                    ++i;
+                    if (i != l && *i == '\r') {
+                        ++i;
+                    }
+                }
+                else if (*i == '\r') {
+                    trim_spaces();
+                    out += '\n';
+                    ++i;
+                    if (i != l && *i == '\n') {
+                        ++i;
+                    }
+                }
+                else {
+                    out += *i;
+                    ++i;
+                }
+            }
+            out += '\n';
+            indent();
+        }
+
+        // The contents of an escape are written without any formatting.
+        template <typename Iterator>
+        void print_escape(Iterator f, Iterator l)
+        {
+            while (f != l && std::isspace(*f)) {
+                ++f;
+            }
+            while (f != l && std::isspace(*(l - 1))) {
+                --l;
+            }
+            out.append(f, l);
+        }
+
+        char prev;
+        std::string& out;
+        int& current_indent;
+        int column;
+        bool in_string;
+        int linewidth;
+
+      private:
+        pretty_printer& operator=(pretty_printer const&);
+    };
+
+    // Sorted, see string_table.hpp.
+    constexpr detail::static_string html_block_tags_[] = {
+        "address",  "blockquote", "body", "dd", "div",      "dl", "dt",
+        "fieldset", "form",       "h1",   "h2", "h3",       "h4", "h5",
+        "h6",       "hr",         "html", "li", "noscript", "ol", "p",
+        "table",    "tbody",      "td",   "th", "thead",    "tr", "ul"};
+
+    static_assert(
+        detail::is_sorted_table(html_block_tags_),
+        "html_block_tags_ isn't sorted");
+
+    // Formats markup as it's written, producing the same output as
+    // running 'post_process' over it afterwards. Markup is tokenized using
+    // the same rules as 'tidy_grammar', and any which is split over
+    // several writes is kept in 'pending' until it's complete. Tags can
+    // also be printed directly, with 'begin_tag' etc., as 'html_printer'
+    // does.
+    struct tidy_printer
+    {
+        // What to do with whitespace before the next token.
+        enum whitespace_type
+        {
+            skip_whitespace,
+            print_whitespace,
+            raw_whitespace
+        };
+
+        // 'indent' and 'linewidth' are as for 'post_process'.
+        tidy_printer(
+            std::string& out, int indent, int linewidth, bool is_html);
+
+        void write(quickbook::string_view);
+
+        // Write anything that's pending, returns false if the markup
+        // wasn't well formed, in which case it might be badly indented.
+        bool finish();
+
+        // The length of the start of the output which won't be changed by
+        // later writes, so that it can be moved elsewhere.
+        std::size_t complete_size() const;
+
+        bool is_flow_tag(quickbook::string_view name) const
+        {
+            return !block_tags.contains(name);
+        }
+
+        void begin_tag(bool flow)
+        {
+            current_tag_is_flow = flow;
+            if (!flow) {
+                printer.align_indent();
+            }
+        }
+
+        void end_open_tag(bool flow)
+        {
+            tags.push_back(flow);
+            if (!flow) {
+                current_indent += indent_width;
+                printer.break_line();
+            }
+            whitespace = flow ? print_whitespace : skip_whitespace;
+        }
+
+        void end_empty_tag(bool flow)
+        {
+            if (!flow) {
+                printer.break_line();
+            }
+            whitespace = flow ? print_whitespace : skip_whitespace;
+        }
+
+        // Returns true if the closed tag is a flow tag.
+        bool begin_close_tag()
+        {
+            bool flow = true;
+            if (tags.empty()) {
+                failed = true;
+            }
+            else {
+                flow = tags.back();
+                tags.pop_back();
+            }
+            if (!flow) {
+                current_indent -= indent_width;
+                printer.align_indent();
+            }
+            return flow;
+        }
+
+        bool is_html;
+        int indent_width;
+        int current_indent;
+        pretty_printer printer;
+        detail::string_table block_tags;
+        // The open tags, true for flow tags.
+        std::vector<bool> tags;
+        // The last tag name that was read, comments are formatted using
+        // it, as in 'post_process'.
+        bool current_tag_is_flow;
+        whitespace_type whitespace;
+        // Set while a tag is being printed directly.
+        bool in_tag;
+        bool tag_is_flow;
+        std::string pending;
+        // How much of 'pending' has been searched for the end of the
+        // markup.
+        std::size_t searched;
+        bool failed;
+
+      private:
+        tidy_printer(tidy_printer const&);
+        tidy_printer& operator=(tidy_printer const&);
+
+        std::size_t scan(quickbook::string_view, std::size_t searched);
+        std::size_t scan_markup(quickbook::string_view, std::size_t);
+        void print_markup(quickbook::string_view, bool is_start_tag);
+    };
+}
+
+#endif
@@ -10,7 +10,6 @@
 #include "quickbook.hpp"
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/split.hpp>
-#include <boost/filesystem/fstream.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
 #include <boost/program_options.hpp>
@@ -26,11 +25,16 @@
 #include "grammar.hpp"
 #include "path.hpp"
 #include "post_process.hpp"
+#include "pretty_printer.hpp"
+#include "spill_file.hpp"
 #include "state.hpp"
 #include "stream.hpp"
+#include "template_library.hpp"
 #include "utils.hpp"
+#include "vfs.hpp"
 
 #include <iterator>
+#include <memory>
 #include <stdexcept>
 #include <vector>
 
@@ -43,73 +47,11 @@
 #pragma warning(disable : 4355)
 #endif
 
-#define QUICKBOOK_VERSION "Quickbook Version 1.7.2"
-
 namespace quickbook
 {
     namespace cl = boost::spirit::classic;
     namespace fs = boost::filesystem;
 
-    tm* current_time;    // the current time
-    tm* current_gm_time; // the current UTC time
-    bool debug_mode;     // for quickbook developers only
-    bool self_linked_headers;
-    std::vector<fs::path> include_path;
-    std::vector<std::string> preset_defines;
-    fs::path image_location;
-
-    static void set_macros(quickbook::state& state)
-    {
-        QUICKBOOK_FOR (quickbook::string_view val, preset_defines) {
-            parse_iterator first(val.begin());
-            parse_iterator last(val.end());
-
-            cl::parse_info<parse_iterator> info =
-                cl::parse(first, last, state.grammar().command_line_macro);
-
-            if (!info.full) {
-                detail::outerr() << "Error parsing command line definition: '"
-                                 << val << "'" << std::endl;
-                ++state.error_count;
-            }
-        }
-    }
-
-    ///////////////////////////////////////////////////////////////////////////
-    //
-    //  Parse a file
-    //
-    ///////////////////////////////////////////////////////////////////////////
-    void parse_file(
-        quickbook::state& state, value include_doc_id, bool nested_file)
-    {
-        parse_iterator first(state.current_file->source().begin());
-        parse_iterator last(state.current_file->source().end());
-
-        cl::parse_info<parse_iterator> info =
-            cl::parse(first, last, state.grammar().doc_info);
-        assert(info.hit);
-
-        if (!state.error_count) {
-            std::string doc_type =
-                pre(state, info.stop, include_doc_id, nested_file);
-
-            info = cl::parse(
-                info.hit ? info.stop : first, last,
-                state.grammar().block_start);
-
-            post(state, doc_type);
-
-            if (!info.full) {
-                file_position const& pos =
-                    state.current_file->position_of(info.stop.base());
-                detail::outerr(state.current_file->path, pos.line)
-                    << "Syntax Error near column " << pos.column << ".\n";
-                ++state.error_count;
-            }
-        }
-    }
-
     struct parse_document_options
     {
         enum output_format
@@ -132,6 +74,8 @@ namespace quickbook
             , linewidth(-1)
             , pretty_print(true)
             , strict_mode(false)
+            , skip_unchanged(false)
+            , spill_threshold(0)
             , deps_out_flags(quickbook::dependency_tracker::default_)
         {
         }
@@ -143,6 +87,10 @@ namespace quickbook
         int linewidth;
         bool pretty_print;
         bool strict_mode;
+        bool skip_unchanged;
+        // If non-zero, the intermediate boostbook is moved to a temporary
+        // file whenever more than this many bytes are held in memory.
+        std::size_t spill_threshold;
         fs::path deps_out;
         quickbook::dependency_tracker::flags deps_out_flags;
         fs::path locations_out;
@@ -150,15 +98,25 @@ namespace quickbook
         quickbook::detail::html_options html_ops;
     };
 
+    static int write_spilled_output(
+        string_stream&, spill_file&, document_state const&,
+        parse_document_options const&);
+
     static int parse_document(
         fs::path const& filein_, parse_document_options const& options_)
     {
         string_stream buffer;
         document_state output;
+        std::unique_ptr<spill_file> spill;
 
         int result = 0;
 
         try {
+            if (options_.spill_threshold) {
+                spill.reset(new spill_file());
+                buffer.spill_to(spill.get(), options_.spill_threshold);
+            }
+
             quickbook::state state(
                 filein_, options_.xinclude_base, buffer, output);
             state.strict_mode = options_.strict_mode;
@@ -184,7 +142,6 @@ namespace quickbook
             }
 
             if (!options_.locations_out.empty()) {
-                fs::ofstream out(options_.locations_out);
                 state.dependencies.write_dependencies(
                     options_.locations_out, dependency_tracker::checked);
             }
@@ -196,10 +153,17 @@ namespace quickbook
             result = 1;
         }
 
+        // Free any files that were prefetched, but never included.
+        reset_prefetch();
+
         if (result) {
             return result;
         }
 
+        if (options_.style && spill) {
+            return write_spilled_output(buffer, *spill, output, options_);
+        }
+
         if (options_.style) {
             std::string stage2 = output.replace_placeholders(buffer.str());
 
@@ -229,30 +193,201 @@ namespace quickbook
                     stage2, options_.html_ops);
             }
             else {
-                fs::ofstream fileout(options_.output_path);
-
-                if (fileout.fail()) {
+                file_system& files = get_file_system();
+                bool success =
+                    options_.skip_unchanged
+                        ? update_file(files, options_.output_path, stage2) !=
+                              update_failed
+                        : files.write(options_.output_path, stage2);
+
+                if (!success) {
                     ::quickbook::detail::outerr()
-                        << "Error opening output file " << options_.output_path
-                        << std::endl;
+                        << "Error writing to output file "
+                        << options_.output_path << std::endl;
 
                     return 1;
                 }
+            }
+        }
+
+        return result;
+    }
+
+    // The same as the end of 'parse_document', but the boostbook is read
+    // back from 'spill' in blocks, and each stage writes its result
+    // straight to the next, so that the whole document is never held in
+    // memory (apart from when it's converted to html). The output file is
+    // always rewritten, as checking if it's changed would need all of it.
+    static int write_spilled_output(
+        string_stream& buffer,
+        spill_file& spill,
+        document_state const& output,
+        parse_document_options const& options_)
+    {
+        bool const is_html = options_.format == parse_document_options::html;
+        file_system& files = get_file_system();
+        std::string boostbook; // Only used for html.
+
+        auto write = [&](quickbook::string_view x) -> bool {
+            if (is_html) {
+                boostbook.append(x.begin(), x.end());
+                return true;
+            }
+            return files.append(options_.output_path, x);
+        };
+
+        auto copy = [&](spill_file& in) -> bool {
+            std::string block;
+            in.rewind();
+            while (in.read(block)) {
+                if (!write(block)) return false;
+            }
+            return true;
+        };
+
+        int result = 0;
+        bool success = true;
 
-                fileout << stage2;
+        try {
+            buffer.spill();
+            spill_file resolved;
+            output.replace_placeholders(spill, resolved);
+            spill.clear();
+
+            success = is_html || files.write(options_.output_path, "");
+
+            if (success && options_.pretty_print) {
+                std::string tidy, block;
+                tidy_printer printer(
+                    tidy, options_.indent, options_.linewidth, false);
+
+                resolved.rewind();
+                while (success && !printer.failed && resolved.read(block)) {
+                    printer.write(block);
+                    std::size_t n = printer.complete_size();
+                    success =
+                        write(quickbook::string_view(tidy.data(), n));
+                    tidy.erase(0, n);
+                }
 
-                if (fileout.fail()) {
+                if (!printer.finish()) {
                     ::quickbook::detail::outerr()
-                        << "Error writing to output file "
-                        << options_.output_path << std::endl;
+                        << "Post Processing Failed." << std::endl;
+                    if (is_html) {
+                        return 1;
+                    }
 
-                    return 1;
+                    // Can still write out a boostbook file, but return an
+                    // error code.
+                    result = 1;
+                    success = files.write(options_.output_path, "") &&
+                              copy(resolved);
                 }
+                else if (success) {
+                    success = write(tidy);
+                }
+            }
+            else if (success) {
+                success = copy(resolved);
             }
+        } catch (std::runtime_error& e) {
+            detail::outerr() << e.what() << std::endl;
+            return 1;
+        }
+
+        if (!success) {
+            ::quickbook::detail::outerr()
+                << "Error writing to output file " << options_.output_path
+                << std::endl;
+
+            return 1;
+        }
+
+        if (is_html) {
+            return quickbook::detail::boostbook_to_html(
+                boostbook, options_.html_ops);
         }
 
         return result;
     }
+
+    // Parse 'filein_' as if it was imported into a new document, recording
+    // its templates and macros.
+    static int precompile_library(
+        fs::path const& filein_, fs::path const& fileout_)
+    {
+        string_stream buffer;
+        document_state output;
+        template_library library;
+
+        try {
+            quickbook::state state(filein_, fs::path(), buffer, output);
+            // Command line macros are checked when the library is imported,
+            // so they aren't recorded.
+            set_macros(state);
+            state.library = &library;
+
+            if (state.error_count == 0) {
+                // Libraries that don't specify a version are compiled for
+                // the latest version.
+                unsigned const default_version = 107;
+                qbk_version_n = default_version;
+                state.document.start_file_with_docinfo(
+                    default_version, quickbook::string_view(),
+                    quickbook::string_view(), value());
+
+                state.current_file = load(filein_); // Throws load_error
+                state.current_path = quickbook_path(
+                    filein_, 0,
+                    fs::path(template_library_directory) /
+                        filein_.filename());
+                state.imported = true;
+                state.update_filename_macro();
+                library.add_source(
+                    filein_, state.current_path.abstract_file_path);
+
+                source_mode_type source_mode = state.source_mode.source_mode;
+                parse_file(state, value(), true);
+
+                library.qbk_version = state.current_file->version();
+                library.fixed_version = library.qbk_version != default_version;
+                library.defines = preset_defines;
+
+                if (state.source_mode.source_mode != source_mode) {
+                    detail::outerr(filein_)
+                        << "Libraries can't change the source mode."
+                        << std::endl;
+                    ++state.error_count;
+                }
+            }
+
+            if (state.error_count) {
+                detail::outerr() << "Error count: " << state.error_count
+                                 << ".\n";
+                return 1;
+            }
+
+            library.finish();
+            std::string data = library.serialize();
+            if (!get_file_system().write(
+                    fileout_, data, file_system::binary_mode)) {
+                detail::outerr()
+                    << "Error writing to output file " << fileout_ << std::endl;
+                return 1;
+            }
+        } catch (load_error& e) {
+            detail::outerr(filein_) << e.what() << std::endl;
+            return 1;
+        } catch (template_library_error& e) {
+            detail::outerr(filein_) << e.what() << std::endl;
+            return 1;
+        } catch (std::runtime_error& e) {
+            detail::outerr() << e.what() << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -284,7 +419,6 @@ int main(int argc, char* argv[])
 
         // Various initialisation methods
         quickbook::detail::initialise_output();
-        quickbook::detail::initialise_markups();
 
         // Declare the program options
 
@@ -314,17 +448,22 @@ int main(int argc, char* argv[])
             ("output-file", PO_VALUE<command_line_string>(), "output file (for boostbook or onehtml)")
             ("output-dir", PO_VALUE<command_line_string>(), "output directory (for html)")
             ("no-output", "don't write out the result")
+            ("skip-unchanged", "don't rewrite output files that haven't changed")
+            ("spill-threshold", PO_VALUE<unsigned>(), "move intermediate output to a temporary file past this many megabytes")
             ("output-deps", PO_VALUE<command_line_string>(), "output dependency file")
             ("ms-errors", "use Microsoft Visual Studio style error & warn message format")
             ("include-path,I", PO_VALUE< std::vector<command_line_string> >(), "include path")
             ("define,D", PO_VALUE< std::vector<command_line_string> >(), "define macro")
             ("image-location", PO_VALUE<command_line_string>(), "image location")
+            ("precompile", "precompile the templates and macros in a file, for faster importing")
         ;
 
         html_desc.add_options()
             ("boost-root-path", PO_VALUE<command_line_string>(), "boost root (file path or absolute URL)")
             ("css-path", PO_VALUE<command_line_string>(), "css file (file path or absolute URL)")
-            ("graphics-path", PO_VALUE<command_line_string>(), "graphics directory (file path or absolute URL)");
+            ("graphics-path", PO_VALUE<command_line_string>(), "graphics directory (file path or absolute URL)")
+            ("gzip", "also write a gzip compressed copy of each html file")
+            ("search-index", "write a search index for the html output");
         desc.add(html_desc);
 
         hidden.add_options()
@@ -338,6 +477,9 @@ int main(int argc, char* argv[])
             ("output-deps-format", PO_VALUE<command_line_string>(),
              "Comma separated list of formatting options for output-deps, "
              "options are: escaped, checked")
+            ("prefetch-threads", PO_VALUE<unsigned>(),
+             "Number of threads used to read included files ahead of "
+             "time, 0 to disable.")
             ("output-checked-locations", PO_VALUE<command_line_string>(),
              "Writes a file listing all the file locations that were "
              "checked, starting with '+' if they were found, or '-' "
@@ -417,6 +559,17 @@ int main(int argc, char* argv[])
 
         options.strict_mode = !!vm.count("strict");
 
+        if (vm.count("skip-unchanged")) {
+            options.skip_unchanged = true;
+            options.html_ops.skip_unchanged = true;
+        }
+
+        if (vm.count("spill-threshold")) {
+            options.spill_threshold =
+                std::size_t(vm["spill-threshold"].as<unsigned>()) * 1024 *
+                1024;
+        }
+
         if (vm.count("indent")) options.indent = vm["indent"].as<int>();
 
         if (vm.count("linewidth"))
@@ -474,6 +627,11 @@ int main(int argc, char* argv[])
             quickbook::debug_mode = false;
         }
 
+        if (vm.count("prefetch-threads")) {
+            quickbook::set_prefetch_threads(
+                vm["prefetch-threads"].as<unsigned>());
+        }
+
         quickbook::include_path.clear();
         if (vm.count("include-path")) {
             boost::transform(
@@ -500,6 +658,28 @@ int main(int argc, char* argv[])
                 ++error_count;
             }
 
+            if (vm.count("precompile")) {
+                // '[import]' only looks for the library next to the source
+                // file, so it can't be written anywhere else.
+                fs::path fileout = quickbook::template_library_path(filein);
+                if (vm.count("output-file")) {
+                    quickbook::detail::outerr()
+                        << "--output-file can't be used with --precompile, "
+                        << "the library is always written to " << fileout
+                        << std::endl;
+                    ++error_count;
+                }
+
+                if (!error_count) {
+                    quickbook::detail::out()
+                        << "Generating library: " << fileout << std::endl;
+                    error_count += quickbook::precompile_library(
+                        fs::absolute(filein), fileout);
+                }
+
+                return expect_errors ? !error_count : error_count;
+            }
+
             if (vm.count("output-deps")) {
                 alt_output_specified = true;
                 options.deps_out = quickbook::detail::command_line_to_path(
@@ -577,6 +757,18 @@ int main(int argc, char* argv[])
                     options.html_ops.boost_root_path / "doc/src/images";
             }
 
+            options.html_ops.gzip_output = !!vm.count("gzip");
+#if !defined(QUICKBOOK_GZIP)
+            if (options.html_ops.gzip_output) {
+                quickbook::detail::outerr()
+                    << "--gzip isn't supported, quickbook was built without "
+                       "'quickbook-gzip=on'"
+                    << std::endl;
+                ++error_count;
+            }
+#endif
+            options.html_ops.write_search_index = !!vm.count("search-index");
+
             if (vm.count("output-file")) {
                 output_specified = true;
                 switch (options.style) {
@@ -19,6 +19,8 @@
 #include "fwd.hpp"
 #include "values.hpp"
 
+#define QUICKBOOK_VERSION "Quickbook Version 1.7.2"
+
 namespace quickbook
 {
     namespace fs = boost::filesystem;
@@ -31,17 +33,13 @@ namespace quickbook
     extern std::vector<std::string> preset_defines;
     extern fs::path image_location;
 
+    // Define the macros from 'preset_defines'.
+    void set_macros(quickbook::state& state);
+
     void parse_file(
         quickbook::state& state,
         value include_doc_id = value(),
         bool nested_file = false);
-    // Some initialisation methods
-    //
-    // Declared here to avoid including other headers
-    namespace detail
-    {
-        void initialise_markups();
-    }
 }
 
 #endif
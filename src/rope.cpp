@@ -0,0 +1,72 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#include "rope.hpp"
+#include <utility>
+#include "for.hpp"
+
+namespace quickbook
+{
+    rope::rope() : chunks_(), size_(0) {}
+
+    rope::rope(std::string const& x) : chunks_(), size_(0)
+    {
+        append(std::string(x));
+    }
+
+    rope::rope(std::string&& x) : chunks_(), size_(0) { append(std::move(x)); }
+
+    void rope::append(chunk const& x)
+    {
+        if (!x->empty()) {
+            chunks_.push_back(x);
+            size_ += x->size();
+        }
+    }
+
+    void rope::append(std::string&& x)
+    {
+        if (!x.empty()) {
+            size_ += x.size();
+            chunks_.push_back(chunk(new std::string(std::move(x))));
+        }
+    }
+
+    void rope::append(rope const& x)
+    {
+        chunks_.insert(chunks_.end(), x.chunks_.begin(), x.chunks_.end());
+        size_ += x.size_;
+    }
+
+    void rope::clear()
+    {
+        chunks_.clear();
+        size_ = 0;
+    }
+
+    void rope::swap(rope& x)
+    {
+        chunks_.swap(x.chunks_);
+        std::swap(size_, x.size_);
+    }
+
+    void rope::write(std::string& out) const
+    {
+        out.reserve(out.size() + size_);
+        QUICKBOOK_FOR (chunk const& x, chunks_) {
+            out += *x;
+        }
+    }
+
+    std::string rope::str() const
+    {
+        std::string result;
+        write(result);
+        return result;
+    }
+}
@@ -0,0 +1,55 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+// A string made of reference counted, immutable chunks. Encoded values
+// are stored as ropes, so that nested output can be written into its
+// parent, and from there into the grandparent, without copying the text
+// each time. It's only joined into a single string when it's finally
+// needed.
+
+#if !defined(BOOST_QUICKBOOK_ROPE_HPP)
+#define BOOST_QUICKBOOK_ROPE_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+namespace quickbook
+{
+    struct rope
+    {
+        typedef boost::shared_ptr<std::string const> chunk;
+        typedef std::vector<chunk>::const_iterator iterator;
+
+        rope();
+        explicit rope(std::string const&);
+        explicit rope(std::string&&);
+
+        bool empty() const { return size_ == 0; }
+        std::size_t size() const { return size_; }
+        iterator begin() const { return chunks_.begin(); }
+        iterator end() const { return chunks_.end(); }
+
+        void append(chunk const&);
+        void append(std::string&&);
+        void append(rope const&);
+        void clear();
+        void swap(rope&);
+
+        // Copy the text to the end of 'out'.
+        void write(std::string& out) const;
+        std::string str() const;
+
+      private:
+        std::vector<chunk> chunks_;
+        std::size_t size_;
+    };
+}
+
+#endif
@@ -0,0 +1,189 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#include "search_index.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "for.hpp"
+
+namespace quickbook
+{
+    namespace detail
+    {
+        namespace
+        {
+            std::size_t const block_size = 16384;
+            // Longer words are unlikely to be searched for, and would
+            // mostly be things like encoded data.
+            std::size_t const max_term_length = 64;
+
+            bool is_word_char(char c)
+            {
+                unsigned char u = static_cast<unsigned char>(c);
+                return (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z') ||
+                       (u >= '0' && u <= '9') || u == '_' || u >= 0x80;
+            }
+
+            char to_lower(char c)
+            {
+                return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a')
+                                            : c;
+            }
+
+            void write_json_string(std::string& out, quickbook::string_view x)
+            {
+                out += '"';
+                QUICKBOOK_FOR (char c, x) {
+                    switch (c) {
+                    case '"':
+                        out += "\\\"";
+                        break;
+                    case '\\':
+                        out += "\\\\";
+                        break;
+                    case '\n':
+                        out += "\\n";
+                        break;
+                    case '\t':
+                        out += "\\t";
+                        break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20) {
+                            char buffer[8];
+                            std::sprintf(
+                                buffer, "\\u%04x", static_cast<unsigned>(c));
+                            out += buffer;
+                        }
+                        else {
+                            out += c;
+                        }
+                    }
+                }
+                out += '"';
+            }
+
+            void write_number(std::string& out, unsigned x)
+            {
+                char buffer[16];
+                std::sprintf(buffer, "%u", x);
+                out += buffer;
+            }
+        }
+
+        search_index::search_index()
+            : documents_(), terms_(), blocks_(), block_pos_(0), block_left_(0)
+        {
+        }
+
+        search_index::~search_index() {}
+
+        void search_index::add_document(
+            quickbook::string_view path, quickbook::string_view title)
+        {
+            documents_.push_back(std::make_pair(path.to_s(), title.to_s()));
+        }
+
+        void search_index::add_text(quickbook::string_view text)
+        {
+            if (documents_.empty()) return;
+
+            string_iterator it = text.begin(), end = text.end();
+            while (it != end) {
+                it = std::find_if(it, end, is_word_char);
+                string_iterator word_end =
+                    std::find_if_not(it, end, is_word_char);
+                std::size_t length = word_end - it;
+                if (length > 1 && length <= max_term_length) {
+                    word_.clear();
+                    std::transform(
+                        it, word_end, std::back_inserter(word_), to_lower);
+                    add_term(word_);
+                }
+                it = word_end;
+            }
+        }
+
+        void search_index::add_term(quickbook::string_view term)
+        {
+            unsigned document = static_cast<unsigned>(documents_.size() - 1);
+            term_map::iterator pos = terms_.find(term);
+            if (pos == terms_.end()) {
+                pos = terms_.emplace(store(term), std::vector<unsigned>())
+                          .first;
+            }
+            else if (pos->second.back() == document) {
+                return;
+            }
+            pos->second.push_back(document);
+        }
+
+        // Copy a term into the current block, or start a new one.
+        quickbook::string_view search_index::store(quickbook::string_view x)
+        {
+            if (block_left_ < x.size()) {
+                blocks_.push_back(
+                    std::unique_ptr<char[]>(new char[block_size]));
+                block_pos_ = blocks_.back().get();
+                block_left_ = block_size;
+            }
+
+            std::memcpy(block_pos_, x.data(), x.size());
+            quickbook::string_view result(block_pos_, x.size());
+            block_pos_ += x.size();
+            block_left_ -= x.size();
+            return result;
+        }
+
+        std::string search_index::to_json() const
+        {
+            std::string out;
+
+            out += "{\"documents\":[";
+            for (std::size_t i = 0; i < documents_.size(); ++i) {
+                if (i) out += ",\n";
+                out += '[';
+                write_json_string(out, documents_[i].first);
+                out += ',';
+                write_json_string(out, documents_[i].second);
+                out += ']';
+            }
+            out += "],\n\"terms\":{";
+
+            // Sorted, so that the output is stable.
+            std::vector<term_map::const_iterator> sorted;
+            sorted.reserve(terms_.size());
+            for (term_map::const_iterator it = terms_.begin();
+                 it != terms_.end(); ++it) {
+                sorted.push_back(it);
+            }
+            std::sort(
+                sorted.begin(), sorted.end(),
+                [](term_map::const_iterator x, term_map::const_iterator y) {
+                    return x->first < y->first;
+                });
+
+            for (std::size_t i = 0; i < sorted.size(); ++i) {
+                if (i) out += ",\n";
+                write_json_string(out, sorted[i]->first);
+                out += ":[";
+                unsigned previous = 0;
+                std::vector<unsigned> const& postings = sorted[i]->second;
+                for (std::size_t j = 0; j < postings.size(); ++j) {
+                    if (j) out += ',';
+                    write_number(out, postings[j] - previous);
+                    previous = postings[j];
+                }
+                out += ']';
+            }
+            out += "}}\n";
+
+            return out;
+        }
+    }
+}
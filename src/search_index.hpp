@@ -0,0 +1,82 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+// Search index for html output
+//
+// An inverted index from words to the pages and sections which contain
+// them, so that the documentation can be searched in a browser without a
+// server. It's built while the html is generated, and written as JSON:
+//
+//     {
+//         "documents": [["index.html", "Title"], ["a.html#b", "B"], ...],
+//         "terms": {"word": [0, 3, 1], ...}
+//     }
+//
+// Each term maps to the indexes of the documents that contain it, in
+// increasing order, delta encoded (so the example is documents 0, 3 and
+// 4). Terms are lower case, and are made of ASCII letters, digits and
+// underscores, or any non-ASCII characters.
+
+#if !defined(BOOST_QUICKBOOK_SEARCH_INDEX_HPP)
+#define BOOST_QUICKBOOK_SEARCH_INDEX_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/unordered_map.hpp>
+#include "string_view.hpp"
+
+namespace quickbook
+{
+    namespace detail
+    {
+        class search_index
+        {
+          public:
+            search_index();
+            ~search_index();
+
+            // Start a new document, the following text is added to it.
+            void add_document(
+                quickbook::string_view path, quickbook::string_view title);
+
+            // Add the words in 'text' (which should be decoded) to the
+            // current document.
+            void add_text(quickbook::string_view text);
+
+            std::size_t document_count() const { return documents_.size(); }
+            std::size_t term_count() const { return terms_.size(); }
+
+            std::string to_json() const;
+
+          private:
+            search_index(search_index const&);
+            search_index& operator=(search_index const&);
+
+            void add_term(quickbook::string_view);
+            quickbook::string_view store(quickbook::string_view);
+
+            typedef boost::unordered_map<
+                quickbook::string_view,
+                std::vector<unsigned> >
+                term_map;
+
+            std::vector<std::pair<std::string, std::string> > documents_;
+            // The terms' text is kept in blocks which are never moved, so
+            // the keys stay valid.
+            term_map terms_;
+            std::vector<std::unique_ptr<char[]> > blocks_;
+            char* block_pos_;
+            std::size_t block_left_;
+            std::string word_;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,94 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#include "spill_file.hpp"
+#include <stdexcept>
+#include <boost/filesystem/operations.hpp>
+
+namespace quickbook
+{
+    namespace fs = boost::filesystem;
+
+    spill_file::spill_file() : path_(), file_(), size_(0), reading_(false)
+    {
+        boost::system::error_code ec;
+        fs::path dir = fs::temp_directory_path(ec);
+        if (ec) {
+            throw std::runtime_error(
+                "Unable to find a directory for temporary files.");
+        }
+        path_ = dir / fs::unique_path("quickbook-%%%%-%%%%-%%%%-%%%%.tmp");
+        open();
+    }
+
+    spill_file::~spill_file()
+    {
+        file_.close();
+        boost::system::error_code ec;
+        fs::remove(path_, ec);
+    }
+
+    void spill_file::open()
+    {
+        file_.open(
+            path_.string().c_str(), std::ios_base::in | std::ios_base::out |
+                                        std::ios_base::trunc |
+                                        std::ios_base::binary);
+        if (!file_) {
+            throw std::runtime_error(
+                "Unable to create temporary file " + path_.string() + ".");
+        }
+    }
+
+    void spill_file::write(quickbook::string_view x)
+    {
+        if (reading_) {
+            file_.clear();
+            file_.seekp(0, std::ios_base::end);
+            reading_ = false;
+        }
+        file_.write(x.data(), static_cast<std::streamsize>(x.size()));
+        if (!file_) {
+            throw std::runtime_error(
+                "Error writing to temporary file " + path_.string() + ".");
+        }
+        size_ += x.size();
+    }
+
+    void spill_file::rewind()
+    {
+        file_.flush();
+        file_.clear();
+        file_.seekg(0);
+        reading_ = true;
+    }
+
+    bool spill_file::read(std::string& block)
+    {
+        if (!reading_) {
+            rewind();
+        }
+        block.resize(block_size);
+        file_.read(&block[0], static_cast<std::streamsize>(block_size));
+        block.resize(static_cast<std::size_t>(file_.gcount()));
+        if (file_.bad()) {
+            throw std::runtime_error(
+                "Error reading temporary file " + path_.string() + ".");
+        }
+        return !block.empty();
+    }
+
+    void spill_file::clear()
+    {
+        file_.close();
+        file_.clear();
+        size_ = 0;
+        reading_ = false;
+        open();
+    }
+}
@@ -0,0 +1,61 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+// Temporary file for output which is too large to comfortably keep in
+// memory. It's written to, and then read back sequentially in blocks.
+//
+// This always uses the native file system rather than the current
+// 'file_system', as it's just a way to save memory. The file is removed
+// when the object is destroyed. Errors throw 'std::runtime_error'.
+
+#if !defined(BOOST_QUICKBOOK_SPILL_FILE_HPP)
+#define BOOST_QUICKBOOK_SPILL_FILE_HPP
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <boost/cstdint.hpp>
+#include <boost/filesystem/path.hpp>
+#include "string_view.hpp"
+
+namespace quickbook
+{
+    class spill_file
+    {
+      public:
+        static std::size_t const block_size = 1024 * 1024;
+
+        spill_file();
+        ~spill_file();
+
+        void write(quickbook::string_view);
+        boost::uintmax_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+        // Start reading from the beginning of the file.
+        void rewind();
+        // Read the next block, returns false when there's nothing left.
+        bool read(std::string& block);
+
+        // Remove the contents.
+        void clear();
+
+      private:
+        spill_file(spill_file const&);
+        spill_file& operator=(spill_file const&);
+
+        void open();
+
+        boost::filesystem::path path_;
+        std::fstream file_;
+        boost::uintmax_t size_;
+        bool reading_;
+    };
+}
+
+#endif
@@ -44,12 +44,14 @@ namespace quickbook
         , anchors()
         , warned_about_breaks(false)
         , conditional(true)
+        , conditional_depth(0)
         , document(document_)
         , callouts()
         , callout_depth(0)
         , dependencies()
         , explicit_list(false)
         , strict_mode(false)
+        , library(0)
 
         , imported(false)
         , macro()
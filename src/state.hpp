@@ -48,18 +48,20 @@ namespace quickbook
 
         // global state
         unsigned order_pos;
-        fs::path xinclude_base;
+        interned_path xinclude_base;
         template_stack templates;
         int error_count;
         string_list anchors;
         bool warned_about_breaks;
         bool conditional;
+        int conditional_depth;
         document_state& document;
         value_builder callouts; // callouts are global as
         int callout_depth;      // they don't nest.
         dependency_tracker dependencies;
         bool explicit_list; // set when using a list
         bool strict_mode;
+        template_library* library; // set when precompiling
 
         // state saved for files and templates.
         bool imported;
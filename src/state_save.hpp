@@ -40,7 +40,7 @@ namespace quickbook
         std::string doc_type;
         file_ptr current_file;
         quickbook_path current_path;
-        fs::path xinclude_base;
+        interned_path xinclude_base;
         source_mode_info source_mode;
         string_symbols macro;
         int template_depth;
@@ -7,6 +7,8 @@
 =============================================================================*/
 
 #include "stream.hpp"
+#include <cassert>
+#include <sstream>
 #include "files.hpp"
 #include "path.hpp"
 
@@ -39,14 +41,14 @@ namespace quickbook
             out << from_utf8(x);
         }
 
-        ostream& out()
-        {
-            static ostream x(std::wcout);
-            return x;
-        }
-
         namespace
         {
+            inline ostream& console_out()
+            {
+                static ostream x(std::wcout);
+                return x;
+            }
+
             inline ostream& error_stream()
             {
                 static ostream x(std::wcerr);
@@ -63,14 +65,14 @@ namespace quickbook
             out << x;
         }
 
-        ostream& out()
-        {
-            static ostream x(std::cout);
-            return x;
-        }
-
         namespace
         {
+            inline ostream& console_out()
+            {
+                static ostream x(std::cout);
+                return x;
+            }
+
             inline ostream& error_stream()
             {
                 static ostream x(std::clog);
@@ -80,11 +82,106 @@ namespace quickbook
 
 #endif
 
-        ostream& outerr() { return error_stream() << "Error: "; }
+        //
+        // Capturing diagnostics
+        //
+
+        struct diagnostic_capture::impl
+        {
+#if QUICKBOOK_WIDE_STREAMS
+            typedef std::wostringstream buffer_type;
+#else
+            typedef std::ostringstream buffer_type;
+#endif
+
+            buffer_type buffer;
+            ostream stream;
+            impl* previous;
+            std::vector<diagnostic> diagnostics;
+            // Where each diagnostic's message starts in 'buffer'.
+            std::vector<std::size_t> starts;
+
+            impl() : buffer(), stream(buffer), previous(0) {}
+
+            ostream& add(
+                diagnostic::severity_type severity,
+                fs::path const& file,
+                std::ptrdiff_t line)
+            {
+                diagnostics.push_back(diagnostic());
+                diagnostics.back().severity = severity;
+                diagnostics.back().file = file;
+                diagnostics.back().line = line;
+                starts.push_back(static_cast<std::size_t>(buffer.tellp()));
+                return stream;
+            }
+        };
+
+        namespace
+        {
+            diagnostic_capture::impl* current_capture = 0;
+        }
+
+        diagnostic_capture::diagnostic_capture() : impl_(new impl())
+        {
+            impl_->previous = current_capture;
+            current_capture = impl_;
+        }
+
+        diagnostic_capture::~diagnostic_capture()
+        {
+            assert(current_capture == impl_);
+            current_capture = impl_->previous;
+            delete impl_;
+        }
+
+        std::vector<diagnostic> diagnostic_capture::diagnostics() const
+        {
+            stream_string text = impl_->buffer.str();
+            std::vector<diagnostic> result = impl_->diagnostics;
+
+            for (std::size_t i = 0; i < result.size(); ++i) {
+                std::size_t end = i + 1 < result.size() ? impl_->starts[i + 1]
+                                                        : text.size();
+                stream_string message =
+                    text.substr(impl_->starts[i], end - impl_->starts[i]);
+                while (!message.empty() &&
+                       (message[message.size() - 1] == '\n' ||
+                        message[message.size() - 1] == '\r')) {
+                    message.erase(message.size() - 1);
+                }
+#if QUICKBOOK_WIDE_STREAMS
+                result[i].message = to_utf8(message);
+#else
+                result[i].message = message;
+#endif
+            }
+
+            return result;
+        }
+
+        ostream& out()
+        {
+            if (current_capture) {
+                return current_capture->add(diagnostic::info, fs::path(), -1);
+            }
+            return console_out();
+        }
+
+        ostream& outerr()
+        {
+            if (current_capture) {
+                return current_capture->add(diagnostic::error, fs::path(), -1);
+            }
+            return error_stream() << "Error: ";
+        }
 
         ostream& outerr(fs::path const& file, std::ptrdiff_t line)
         {
-            if (line >= 0) {
+            if (current_capture) {
+                return current_capture->add(diagnostic::error, file, line);
+            }
+            else if (line >= 0) {
                 if (ms_errors)
                     return error_stream() << path_to_stream(file) << "(" << line
                                           << "): error: ";
@@ -104,7 +201,10 @@ namespace quickbook
 
         ostream& outwarn(fs::path const& file, std::ptrdiff_t line)
         {
-            if (line >= 0) {
+            if (current_capture) {
+                return current_capture->add(diagnostic::warning, file, line);
+            }
+            else if (line >= 0) {
                 if (ms_errors)
                     return error_stream() << path_to_stream(file) << "(" << line
                                           << "): warning: ";
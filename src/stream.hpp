@@ -12,6 +12,8 @@
 #define BOOST_QUICKBOOK_DETAIL_STREAM_HPP
 
 #include <iostream>
+#include <string>
+#include <vector>
 #include <boost/filesystem/path.hpp>
 #include "native_text.hpp"
 
@@ -79,6 +81,43 @@ namespace quickbook
         ostream& outwarn(fs::path const& file, std::ptrdiff_t line = -1);
         ostream& outerr(file_ptr const&, string_iterator);
         ostream& outwarn(file_ptr const&, string_iterator);
+
+        // A message collected by 'diagnostic_capture'.
+        struct diagnostic
+        {
+            enum severity_type
+            {
+                error,
+                warning,
+                info // Written to 'out()'
+            };
+
+            severity_type severity;
+            fs::path file;       // Empty when not for a file.
+            std::ptrdiff_t line; // -1 when not for a line.
+            std::string message; // UTF-8, without the location.
+        };
+
+        // While an instance exists, errors, warnings and other messages are
+        // collected instead of being written to the console. They can nest,
+        // the innermost one collects the messages.
+        class diagnostic_capture
+        {
+          public:
+            diagnostic_capture();
+            ~diagnostic_capture();
+
+            // The messages collected so far.
+            std::vector<diagnostic> diagnostics() const;
+
+            struct impl;
+
+          private:
+            impl* impl_;
+
+            diagnostic_capture(diagnostic_capture const&);
+            diagnostic_capture& operator=(diagnostic_capture const&);
+        };
     }
 }
 
@@ -0,0 +1,99 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+// Fixed sets of strings, such as tag names, which are built at compile
+// time. The strings are written in sorted order (checked with
+// 'is_sorted_table' in a static assert) and are binary searched, so a
+// lookup doesn't allocate, and there's nothing to set up at startup.
+
+#if !defined(BOOST_QUICKBOOK_STRING_TABLE_HPP)
+#define BOOST_QUICKBOOK_STRING_TABLE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include "string_view.hpp"
+
+namespace quickbook
+{
+    namespace detail
+    {
+        struct static_string
+        {
+            template <std::size_t N>
+            constexpr static_string(char const (&s)[N]) : data(s), size(N - 1)
+            {
+            }
+
+            char const* data;
+            std::size_t size;
+        };
+
+        // Compares characters as unsigned, like 'std::char_traits<char>'.
+        constexpr bool static_string_less(
+            char const* x,
+            std::size_t x_size,
+            char const* y,
+            std::size_t y_size)
+        {
+            return y_size == 0
+                       ? false
+                       : x_size == 0
+                             ? true
+                             : *x != *y
+                                   ? static_cast<unsigned char>(*x) <
+                                         static_cast<unsigned char>(*y)
+                                   : static_string_less(
+                                         x + 1, x_size - 1, y + 1,
+                                         y_size - 1);
+        }
+
+        template <std::size_t N>
+        constexpr bool is_sorted_table(
+            static_string const (&table)[N], std::size_t i = 1)
+        {
+            return i >= N ||
+                   (static_string_less(
+                        table[i - 1].data, table[i - 1].size, table[i].data,
+                        table[i].size) &&
+                    is_sorted_table(table, i + 1));
+        }
+
+        class string_table
+        {
+          public:
+            template <std::size_t N>
+            constexpr string_table(static_string const (&table)[N])
+                : begin_(table), end_(table + N)
+            {
+            }
+
+            bool contains(quickbook::string_view x) const
+            {
+                static_string const* it =
+                    std::lower_bound(begin_, end_, x, compare());
+                return it != end_ &&
+                       quickbook::string_view(it->data, it->size) == x;
+            }
+
+          private:
+            struct compare
+            {
+                bool operator()(
+                    static_string const& x, quickbook::string_view y) const
+                {
+                    return quickbook::string_view(x.data, x.size) < y;
+                }
+            };
+
+            static_string const* begin_;
+            static_string const* end_;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,203 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#include "svg_size.hpp"
+#include <ctime>
+#include <boost/unordered_map.hpp>
+#include "vfs.hpp"
+
+namespace quickbook
+{
+    namespace
+    {
+        typedef quickbook::string_view::size_type size_type;
+        size_type const npos = quickbook::string_view::npos;
+
+        bool is_space(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+        }
+
+        size_type skip_space(quickbook::string_view text, size_type pos)
+        {
+            while (pos < text.size() && is_space(text[pos])) {
+                ++pos;
+            }
+            return pos;
+        }
+
+        // Find the end of a doctype declaration, skipping over any internal
+        // subset, which can contain '>' characters.
+        size_type find_doctype_end(quickbook::string_view text, size_type pos)
+        {
+            int depth = 0;
+            char quote = 0;
+
+            for (; pos < text.size(); ++pos) {
+                char c = text[pos];
+                if (quote) {
+                    if (c == quote) quote = 0;
+                }
+                else if (c == '"' || c == '\'') {
+                    quote = c;
+                }
+                else if (c == '[') {
+                    ++depth;
+                }
+                else if (c == ']') {
+                    if (depth) --depth;
+                }
+                else if (c == '>' && !depth) {
+                    return pos;
+                }
+            }
+
+            return npos;
+        }
+    }
+
+    bool parse_svg_size(quickbook::string_view text, svg_size& size)
+    {
+        size_type pos = 0;
+
+        // Skip the prolog to find the root element's start tag.
+        for (;;) {
+            pos = text.find('<', pos);
+            if (pos == npos || pos + 1 >= text.size()) return false;
+
+            boost::string_view rest = text.substr(pos);
+            size_type end;
+
+            if (rest.starts_with("<?")) {
+                end = text.find("?>", pos + 2);
+                if (end == npos) return false;
+                pos = end + 2;
+            }
+            else if (rest.starts_with("<!--")) {
+                end = text.find("-->", pos + 4);
+                if (end == npos) return false;
+                pos = end + 3;
+            }
+            else if (rest.size() < 4) {
+                // Not enough to tell if it's a comment.
+                return false;
+            }
+            else if (rest[1] == '!') {
+                end = find_doctype_end(text, pos + 2);
+                if (end == npos) return false;
+                pos = end + 1;
+            }
+            else {
+                break;
+            }
+        }
+
+        // The element name, ignoring any namespace prefix.
+        size_type name_start = ++pos;
+        while (pos < text.size() && !is_space(text[pos]) && text[pos] != '/' &&
+               text[pos] != '>') {
+            ++pos;
+        }
+        if (pos == text.size()) return false;
+
+        boost::string_view name = text.substr(name_start, pos - name_start);
+        size_type colon = name.find(':');
+        if (colon != npos) name = name.substr(colon + 1);
+        if (name != "svg") return true;
+
+        // Attributes
+        for (;;) {
+            pos = skip_space(text, pos);
+            if (pos == text.size()) return false;
+            if (text[pos] == '>' || text[pos] == '/') return true;
+
+            size_type attribute_start = pos;
+            while (pos < text.size() && !is_space(text[pos]) &&
+                   text[pos] != '=' && text[pos] != '>' && text[pos] != '/') {
+                ++pos;
+            }
+            boost::string_view attribute =
+                text.substr(attribute_start, pos - attribute_start);
+
+            pos = skip_space(text, pos);
+            if (pos == text.size()) return false;
+            if (text[pos] != '=') return true; // Invalid xml, so give up.
+
+            pos = skip_space(text, pos + 1);
+            if (pos == text.size()) return false;
+            char quote = text[pos];
+            if (quote != '"' && quote != '\'') return true;
+
+            size_type value_end = text.find(quote, pos + 1);
+            if (value_end == npos) return false;
+            boost::string_view value =
+                text.substr(pos + 1, value_end - pos - 1);
+            pos = value_end + 1;
+
+            if (attribute == "width" && !size.has_width) {
+                size.has_width = true;
+                size.width.assign(value.begin(), value.end());
+            }
+            else if (attribute == "height" && !size.has_height) {
+                size.has_height = true;
+                size.height.assign(value.begin(), value.end());
+            }
+        }
+    }
+
+    namespace
+    {
+        struct svg_cache_entry
+        {
+            std::time_t modified;
+            svg_size size;
+        };
+
+        boost::unordered_map<fs::path, svg_cache_entry> svg_cache;
+    }
+
+    svg_size read_svg_size(fs::path const& path)
+    {
+        file_system& files = get_file_system();
+        file_status status = files.status(path);
+        if (!status.exists) return svg_size();
+        std::time_t modified = status.modified;
+
+        boost::unordered_map<fs::path, svg_cache_entry>::iterator pos =
+            svg_cache.find(path);
+        if (pos != svg_cache.end() && pos->second.modified == modified) {
+            return pos->second.size;
+        }
+
+        svg_cache_entry entry;
+        entry.modified = modified;
+
+        // The prolog is usually small, so the root element's start tag
+        // is normally in the first block. If it isn't, read a larger
+        // block each time, giving up once 'max_size' has been read rather
+        // than reading the whole of a large file.
+        std::size_t const max_size = 256 * 1024;
+        std::string text;
+        for (std::size_t block_size = 4096;; block_size *= 4) {
+            if (!files.read(path, text, block_size)) break;
+
+            // If the whole file has been read, use whatever was found.
+            svg_size size;
+            if (parse_svg_size(text, size) || text.size() < block_size) {
+                entry.size = size;
+                break;
+            }
+            if (block_size >= max_size) break;
+        }
+
+        svg_cache[path] = entry;
+        return entry.size;
+    }
+
+    void clear_svg_size_cache() { svg_cache.clear(); }
+}
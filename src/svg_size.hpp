@@ -0,0 +1,50 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#if !defined(BOOST_QUICKBOOK_SVG_SIZE_HPP)
+#define BOOST_QUICKBOOK_SVG_SIZE_HPP
+
+#include <string>
+#include <boost/filesystem/path.hpp>
+#include "string_view.hpp"
+
+namespace quickbook
+{
+    namespace fs = boost::filesystem;
+
+    // The width and height attributes from an svg element, as written in
+    // the file (i.e. still xml encoded).
+    struct svg_size
+    {
+        svg_size() : has_width(false), has_height(false) {}
+
+        bool has_width;
+        bool has_height;
+        std::string width;
+        std::string height;
+    };
+
+    // Find the size in the root element's start tag, if the root is an svg
+    // element. Returns false if 'text' ends before the start tag does, in
+    // which case 'size' contains any attributes found so far.
+    bool parse_svg_size(quickbook::string_view text, svg_size& size);
+
+    // Reads just enough of an svg file to find its size. The result is
+    // cached for the rest of the run, and reused if the file's modification
+    // time hasn't changed. Returns an empty size if the file can't be read,
+    // or if the start tag isn't in the first 256KB.
+    svg_size read_svg_size(fs::path const&);
+
+    // Forget the sizes read by 'read_svg_size'. The cache is keyed by path
+    // and a modification time with a resolution of a second, so it has to
+    // be cleared when the file system might change, or be replaced by a
+    // different one.
+    void clear_svg_size_cache();
+}
+
+#endif
@@ -12,6 +12,7 @@
 
 ///////////////////////////////////////////////////////////////////////////////
 
+#include <bitset>
 #include <boost/intrusive_ptr.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/spirit/home/classic/symbols.hpp>
@@ -99,6 +100,7 @@ namespace quickbook
         typedef tst_node<T, CharT> node_t;
         typedef boost::intrusive_ptr<node_t> node_ptr;
         node_ptr root;
+        std::bitset<256> first_chars;
 
       public:
         struct search_info
@@ -107,7 +109,18 @@ namespace quickbook
             std::size_t length;
         };
 
-        void swap(tst& other) { root.swap(other.root); }
+        void swap(tst& other)
+        {
+            root.swap(other.root);
+            boost::core::invoke_swap(first_chars, other.first_chars);
+        }
+
+        // Could a symbol start with 'ch'? Cheaper than a failed 'find',
+        // so it's used to quickly skip over text that can't be a symbol.
+        bool may_start_with(CharT ch) const
+        {
+            return first_chars.test(static_cast<unsigned char>(ch));
+        }
 
         // Adds symbol to ternary search tree.
         // If it already exists, then replace it with new value.
@@ -120,6 +133,7 @@ namespace quickbook
 
             node_ptr* np = &root;
             CharT ch = *first;
+            first_chars.set(static_cast<unsigned char>(ch));
 
             for (;;) {
                 if (!*np) {
@@ -197,6 +211,14 @@ namespace quickbook
     typedef boost::spirit::classic::
         symbols<std::string, char, quickbook::tst<std::string, char> >
             string_symbols;
+
+    // 'symbols' privately inherits from its tst, but a C style cast is
+    // allowed to convert to an inaccessible base class.
+    inline bool symbol_may_start_with(string_symbols const& symbols, char ch)
+    {
+        return ((quickbook::tst<std::string, char> const&)symbols)
+            .may_start_with(ch);
+    }
 } // namespace quickbook
 
 #endif
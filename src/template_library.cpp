@@ -0,0 +1,466 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#include "template_library.hpp"
+#include <algorithm>
+#include "for.hpp"
+#include "path.hpp"
+#include "quickbook.hpp"
+#include "vfs.hpp"
+
+namespace quickbook
+{
+    char const* template_library_directory = "\x01library\x01";
+
+    fs::path template_library_path(fs::path const& source)
+    {
+        fs::path result = source;
+        result += "c";
+        return result;
+    }
+
+    //
+    // File format
+    //
+    // All integers are little endian, strings are a 32-bit length followed
+    // by their contents.
+    //
+    //     magic, format version, quickbook version
+    //     qbk_version, fixed_version, defines
+    //     sources: path, abstract path, hash, qbk_version, text, sections
+    //     definitions
+    //
+    // Anything else (such as a different format or quickbook version) means
+    // that the library is out of date, and is ignored.
+
+    namespace
+    {
+        char const magic[] = "qbklib\n";
+        unsigned const format_version = 2;
+
+        struct library_writer
+        {
+            std::string out;
+
+            void write_int(boost::uint64_t x, unsigned bytes)
+            {
+                for (unsigned i = 0; i < bytes; ++i) {
+                    out += static_cast<char>((x >> (i * 8)) & 0xff);
+                }
+            }
+
+            void write_u32(std::size_t x)
+            {
+                if (x > 0xffffffffu) {
+                    throw template_library_error("Library is too large.");
+                }
+                write_int(x, 4);
+            }
+
+            void write_string(quickbook::string_view x)
+            {
+                write_u32(x.size());
+                out.append(x.begin(), x.end());
+            }
+        };
+
+        // FNV-1a hash of a file's contents, returns false if it can't be
+        // read.
+        bool hash_file(fs::path const& path, boost::uint64_t& hash)
+        {
+            std::string contents;
+            if (!get_file_system().read(path, contents)) return false;
+
+            hash = 14695981039346656037ull;
+            QUICKBOOK_FOR (char c, contents) {
+                hash ^= static_cast<unsigned char>(c);
+                hash *= 1099511628211ull;
+            }
+            return true;
+        }
+
+        // The source that 'f' was loaded from, or 'sources.size()' if it
+        // wasn't loaded from one of them.
+        unsigned find_source(
+            std::vector<template_library::source> const& sources,
+            file_ptr const& f)
+        {
+            if (!f || f->is_code_snippets) return sources.size();
+            unsigned index = 0;
+            for (; index < sources.size(); ++index) {
+                if (sources[index].path == f->path) break;
+            }
+            return index;
+        }
+
+        struct library_reader
+        {
+            quickbook::string_view data;
+            std::size_t pos;
+
+            explicit library_reader(quickbook::string_view data_)
+                : data(data_), pos(0)
+            {
+            }
+
+            void check(std::size_t bytes)
+            {
+                if (data.size() - pos < bytes) {
+                    throw template_library_error("Unexpected end of file.");
+                }
+            }
+
+            boost::uint64_t read_int(unsigned bytes)
+            {
+                check(bytes);
+                boost::uint64_t x = 0;
+                for (unsigned i = 0; i < bytes; ++i) {
+                    x |= static_cast<boost::uint64_t>(
+                             static_cast<unsigned char>(data[pos++]))
+                         << (i * 8);
+                }
+                return x;
+            }
+
+            unsigned read_u32() { return static_cast<unsigned>(read_int(4)); }
+
+            std::string read_string()
+            {
+                std::size_t length = read_u32();
+                check(length);
+                std::string result(data.begin() + pos, length);
+                pos += length;
+                return result;
+            }
+        };
+    }
+
+    template_library::template_library()
+        : qbk_version(0)
+        , fixed_version(false)
+        , defines()
+        , sources()
+        , definitions()
+    {
+    }
+
+    void template_library::add_source(
+        fs::path const& path, fs::path const& abstract_path)
+    {
+        QUICKBOOK_FOR (source const& s, sources) {
+            if (s.path == path) return;
+        }
+
+        sources.push_back(source());
+        sources.back().path = path;
+        sources.back().hash = 0;
+        sources.back().qbk_version = 0;
+
+        // Make the abstract path relative to the importing file's directory.
+        fs::path::const_iterator it = abstract_path.begin(),
+                                 end = abstract_path.end();
+        if (it != end && *it == template_library_directory) {
+            for (++it; it != end; ++it) {
+                sources.back().abstract_path /= *it;
+            }
+        }
+        else {
+            sources.back().abstract_path = abstract_path;
+        }
+    }
+
+    void template_library::add_template(
+        std::string const& identifier,
+        std::vector<std::string> const& params,
+        value const& body)
+    {
+        file_ptr f = body.get_file();
+        unsigned index = find_source(sources, f);
+        if (index == sources.size()) {
+            throw template_library_error(
+                "Template '" + identifier + "' isn't from a quickbook file.");
+        }
+
+        source& s = sources[index];
+        s.qbk_version = f->version();
+
+        quickbook::string_view text = body.get_quickbook();
+        definition d;
+        d.type = definition::template_;
+        d.identifier = identifier;
+        d.params = params;
+        d.tag = body.get_tag();
+        d.source_index = index;
+        d.begin = s.text.size();
+        d.end = d.begin + text.size();
+        s.sections.push_back(
+            std::make_pair(d.begin, f->position_of(body.get_position())));
+        s.text.append(text.begin(), text.end());
+        definitions.push_back(d);
+    }
+
+    void template_library::add_macro(
+        value const& identifier, value const& body)
+    {
+        quickbook::string_view id = identifier.get_quickbook();
+        file_ptr f = identifier.get_file();
+        unsigned index = find_source(sources, f);
+        if (index == sources.size()) {
+            throw template_library_error(
+                "Macro '" + id.to_s() + "' isn't from a quickbook file.");
+        }
+
+        source& s = sources[index];
+        s.qbk_version = f->version();
+
+        // The identifier and value are stored as a '[def ...]' element, so
+        // that they can be parsed again when the library is imported.
+        string_iterator last =
+            body.check() ? body.get_quickbook().end() : id.end();
+
+        definition d;
+        d.type = definition::macro;
+        d.identifier = id.to_s();
+        d.tag = value::default_tag;
+        d.source_index = index;
+        d.begin = s.text.size();
+        s.text += "[def ";
+        s.sections.push_back(
+            std::make_pair(s.text.size(), f->position_of(id.begin())));
+        s.text.append(id.begin(), last);
+        s.text += "]";
+        d.end = s.text.size();
+        definitions.push_back(d);
+    }
+
+    void template_library::finish()
+    {
+        if (sources.empty()) return;
+        fs::path directory = sources.front().path.parent_path();
+
+        QUICKBOOK_FOR (source& s, sources) {
+            if (!hash_file(s.path, s.hash)) {
+                throw template_library_error(
+                    "Error reading " + detail::path_to_generic(s.path));
+            }
+
+            fs::path::const_iterator it = s.path.begin(),
+                                     end = s.path.end();
+            fs::path::const_iterator dir_it = directory.begin(),
+                                     dir_end = directory.end();
+            for (; it != end && dir_it != dir_end && *it == *dir_it;
+                 ++it, ++dir_it) {
+            }
+            if (dir_it == dir_end) {
+                fs::path relative;
+                for (; it != end; ++it) {
+                    relative /= *it;
+                }
+                s.path = relative;
+            }
+        }
+    }
+
+    std::string template_library::serialize() const
+    {
+        library_writer w;
+
+        w.out.append(magic, sizeof(magic) - 1);
+        w.write_u32(format_version);
+        w.write_string(QUICKBOOK_VERSION);
+
+        w.write_u32(qbk_version);
+        w.write_int(fixed_version, 1);
+        w.write_u32(defines.size());
+        QUICKBOOK_FOR (std::string const& x, defines) {
+            w.write_string(x);
+        }
+
+        w.write_u32(sources.size());
+        QUICKBOOK_FOR (source const& s, sources) {
+            w.write_string(detail::path_to_generic(s.path));
+            w.write_string(detail::path_to_generic(s.abstract_path));
+            w.write_int(s.hash, 8);
+            w.write_u32(s.qbk_version);
+            w.write_string(s.text);
+            w.write_u32(s.sections.size());
+            for (std::size_t i = 0; i < s.sections.size(); ++i) {
+                w.write_u32(s.sections[i].first);
+                w.write_u32(s.sections[i].second.line);
+                w.write_u32(s.sections[i].second.column);
+            }
+        }
+
+        w.write_u32(definitions.size());
+        QUICKBOOK_FOR (definition const& d, definitions) {
+            w.write_int(d.type, 1);
+            w.write_string(d.identifier);
+            if (d.type == definition::template_) {
+                w.write_u32(d.params.size());
+                QUICKBOOK_FOR (std::string const& p, d.params) {
+                    w.write_string(p);
+                }
+            }
+            w.write_int(static_cast<unsigned>(d.tag), 4);
+            w.write_u32(d.source_index);
+            w.write_u32(d.begin);
+            w.write_u32(d.end);
+        }
+
+        return w.out;
+    }
+
+    void template_library::deserialize(quickbook::string_view data)
+    {
+        library_reader r(data);
+
+        r.check(sizeof(magic) - 1);
+        if (data.substr(0, sizeof(magic) - 1) != magic) {
+            throw template_library_error("Not a precompiled library.");
+        }
+        r.pos += sizeof(magic) - 1;
+        if (r.read_u32() != format_version ||
+            r.read_string() != QUICKBOOK_VERSION) {
+            throw template_library_error(
+                "Library is from a different version of quickbook.");
+        }
+
+        qbk_version = r.read_u32();
+        fixed_version = r.read_int(1) != 0;
+        defines.resize(r.read_u32());
+        QUICKBOOK_FOR (std::string& x, defines) {
+            x = r.read_string();
+        }
+
+        std::size_t source_count = r.read_u32();
+        sources.clear();
+        for (std::size_t i = 0; i < source_count; ++i) {
+            sources.push_back(source());
+            source& s = sources.back();
+            s.path = detail::generic_to_path(r.read_string());
+            s.abstract_path = detail::generic_to_path(r.read_string());
+            s.hash = r.read_int(8);
+            s.qbk_version = r.read_u32();
+            s.text = r.read_string();
+
+            std::size_t section_count = r.read_u32();
+            for (std::size_t j = 0; j < section_count; ++j) {
+                std::size_t pos = r.read_u32();
+                file_position p;
+                p.line = r.read_u32();
+                p.column = r.read_u32();
+                if (pos > s.text.size() ||
+                    (j && pos < s.sections.back().first)) {
+                    throw template_library_error("Invalid source section.");
+                }
+                s.sections.push_back(std::make_pair(pos, p));
+            }
+        }
+
+        std::size_t definition_count = r.read_u32();
+        definitions.clear();
+        for (std::size_t i = 0; i < definition_count; ++i) {
+            definitions.push_back(definition());
+            definition& d = definitions.back();
+            unsigned type = static_cast<unsigned>(r.read_int(1));
+            if (type > definition::macro) {
+                throw template_library_error("Invalid definition.");
+            }
+            d.type = static_cast<definition::definition_type>(type);
+            d.identifier = r.read_string();
+
+            if (d.type == definition::template_) {
+                d.params.resize(r.read_u32());
+                QUICKBOOK_FOR (std::string& p, d.params) {
+                    p = r.read_string();
+                }
+            }
+            d.tag = static_cast<value::tag_type>(r.read_u32());
+            d.source_index = r.read_u32();
+            d.begin = r.read_u32();
+            d.end = r.read_u32();
+            if (d.source_index >= sources.size() || d.begin > d.end ||
+                d.end > sources[d.source_index].text.size()) {
+                throw template_library_error("Invalid definition.");
+            }
+        }
+
+        if (r.pos != data.size()) {
+            throw template_library_error("Unexpected data at end of file.");
+        }
+    }
+
+    namespace
+    {
+        // A file containing template bodies, each of which is mapped to
+        // its position in the original file.
+        struct library_file : file
+        {
+            typedef std::pair<std::size_t, file_position> section;
+
+            library_file(template_library::source const& s)
+                : file(s.path, s.text, s.qbk_version), sections(s.sections)
+            {
+            }
+
+            std::vector<section> sections;
+
+            struct section_compare
+            {
+                bool operator()(std::size_t pos, section const& s) const
+                {
+                    return pos < s.first;
+                }
+            };
+
+            virtual file_position position_of(string_iterator it) const
+            {
+                std::size_t pos = it - source().begin();
+                std::vector<section>::const_iterator s = std::upper_bound(
+                    sections.begin(), sections.end(), pos, section_compare());
+                if (s == sections.begin()) return file_position();
+                --s;
+
+                file_position p =
+                    relative_position(source().begin() + s->first, it);
+                if (p.line == 1) {
+                    return file_position(
+                        s->second.line, s->second.column + p.column - 1);
+                }
+                else {
+                    return file_position(
+                        s->second.line + p.line - 1, p.column);
+                }
+            }
+        };
+    }
+
+    void template_library::read(fs::path const& path)
+    {
+        std::string data;
+        if (!get_file_system().read(path, data)) {
+            throw template_library_error("Error reading file.");
+        }
+        deserialize(data);
+    }
+
+    bool template_library::up_to_date(fs::path const& directory)
+    {
+        QUICKBOOK_FOR (source& s, sources) {
+            if (!s.path.has_root_directory()) s.path = directory / s.path;
+            boost::uint64_t hash;
+            if (!hash_file(s.path, hash) || hash != s.hash) return false;
+        }
+        return true;
+    }
+
+    file_ptr template_library::load_source(unsigned index) const
+    {
+        return file_ptr(new library_file(sources.at(index)));
+    }
+}
@@ -0,0 +1,133 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+// Precompiled template libraries
+//
+// 'quickbook --precompile' parses a file as if it was being imported, and
+// records the templates and macros that it defines. They're written to
+// a binary file next to the source (e.g. 'templates.qbk' is precompiled to
+// 'templates.qbkc'), which '[import]' loads instead of parsing the source,
+// as long as it's up to date. That's checked with a hash of each source
+// file, as modification times are often too coarse.
+//
+// Template bodies and macro definitions are stored as source text, along
+// with their positions in the original file, so that they're parsed and
+// reported in the same way. Macro definitions are parsed again when the
+// library is imported, so that they use the macros and templates visible
+// where it's imported, as they would if the file was parsed. Definitions
+// inside conditional phrases are rejected when precompiling, as the
+// condition could be different where the library is imported.
+
+#if !defined(BOOST_QUICKBOOK_TEMPLATE_LIBRARY_HPP)
+#define BOOST_QUICKBOOK_TEMPLATE_LIBRARY_HPP
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/filesystem/path.hpp>
+#include "files.hpp"
+#include "fwd.hpp"
+#include "values.hpp"
+
+namespace quickbook
+{
+    namespace fs = boost::filesystem;
+
+    struct template_library_error : std::runtime_error
+    {
+        explicit template_library_error(std::string const& arg)
+            : std::runtime_error(arg)
+        {
+        }
+    };
+
+    struct template_library
+    {
+        struct source
+        {
+            fs::path path; // Relative to the library, if it's inside its
+                           // directory.
+            // The path used for __FILENAME__, relative to the directory of
+            // the file that imports the library, unless it's absolute.
+            fs::path abstract_path;
+            boost::uint64_t hash;
+            unsigned qbk_version;
+            // The template bodies and macro definitions from this file, and
+            // where they start in the original file.
+            std::string text;
+            std::vector<std::pair<std::size_t, file_position> > sections;
+        };
+
+        struct definition
+        {
+            enum definition_type
+            {
+                template_,
+                macro
+            };
+
+            definition_type type;
+            std::string identifier;
+            // Templates only:
+            std::vector<std::string> params;
+            value::tag_type tag;
+            // The template body, or for a macro the whole '[def ...]'
+            // element, in the source's text.
+            unsigned source_index;
+            std::size_t begin, end;
+        };
+
+        template_library();
+
+        // The version the library was compiled with, it's only used when
+        // imported with the same version, unless 'fixed_version' is set
+        // because the file declared its own version.
+        unsigned qbk_version;
+        bool fixed_version;
+        std::vector<std::string> defines;
+        std::vector<source> sources;
+        std::vector<definition> definitions;
+
+        // Recording the definitions while precompiling. 'abstract_path' is
+        // the path that __FILENAME__ is set to for the source, which starts
+        // with 'template_library_directory' if it's relative to the library.
+        void add_source(fs::path const& path, fs::path const& abstract_path);
+        void add_template(
+            std::string const& identifier,
+            std::vector<std::string> const& params,
+            value const& body);
+        // 'body' is empty if the macro doesn't have a value.
+        void add_macro(value const& identifier, value const& body);
+        // Record the hashes of the sources, and make their paths relative
+        // to the library's directory where possible.
+        void finish();
+
+        // Throw template_library_error on failure.
+        std::string serialize() const;
+        void deserialize(quickbook::string_view);
+        void read(fs::path const&);
+
+        // Check that the sources haven't changed since the library was
+        // compiled. 'directory' is the library's directory, relative paths
+        // are resolved against it.
+        bool up_to_date(fs::path const& directory);
+
+        // Create a file containing the template bodies from a source.
+        file_ptr load_source(unsigned index) const;
+    };
+
+    // Where the library for a source file is written.
+    fs::path template_library_path(fs::path const& source);
+
+    // Used in place of the file's directory in __FILENAME__ when
+    // precompiling.
+    extern char const* template_library_directory;
+}
+
+#endif
@@ -40,13 +40,29 @@ namespace quickbook
         parent_1_4 = &scopes.front();
     }
 
+    namespace
+    {
+        template_symbol* find_in_scope(
+            template_scope const& scope, std::string const& symbol)
+        {
+            for (std::vector<template_symbol>::const_iterator
+                     it = scope.arguments.begin(),
+                     end = scope.arguments.end();
+                 it != end; ++it) {
+                if (it->identifier == symbol) {
+                    return const_cast<template_symbol*>(&*it);
+                }
+            }
+
+            return boost::spirit::classic::find(scope.symbols, symbol.c_str());
+        }
+    }
+
     template_symbol* template_stack::find(std::string const& symbol) const
     {
         for (template_scope const* i = &*scopes.begin(); i;
              i = i->parent_scope) {
-            if (template_symbol* ts =
-                    boost::spirit::classic::find(i->symbols, symbol.c_str()))
-                return ts;
+            if (template_symbol* ts = find_in_scope(*i, symbol)) return ts;
         }
         return 0;
     }
@@ -54,8 +70,7 @@ namespace quickbook
     template_symbol* template_stack::find_top_scope(
         std::string const& symbol) const
     {
-        return boost::spirit::classic::find(
-            scopes.front().symbols, symbol.c_str());
+        return find_in_scope(scopes.front(), symbol);
     }
 
     template_symbols const& template_stack::top() const
@@ -85,6 +100,25 @@ namespace quickbook
         return true;
     }
 
+    bool template_stack::add_argument(
+        std::string const& identifier,
+        value const& content,
+        template_scope const* parent)
+    {
+        BOOST_ASSERT(!scopes.empty());
+        BOOST_ASSERT(parent);
+
+        if (this->find_top_scope(identifier)) {
+            return false;
+        }
+
+        static std::vector<std::string> const no_params;
+        scopes.front().arguments.push_back(
+            template_symbol(identifier, no_params, content, parent));
+
+        return true;
+    }
+
     void template_stack::push()
     {
         template_scope const& old_front = scopes.front();
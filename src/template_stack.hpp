@@ -57,6 +57,10 @@ namespace quickbook
     // correct lookup chain for that version of quickboook.
     //
     // symbols contains the templates defined in this scope.
+    //
+    // arguments contains the arguments of the template being expanded in
+    // this scope. They're searched linearly, as there are usually only a
+    // few, and it's much cheaper than building a trie for every call.
 
     struct template_scope
     {
@@ -64,6 +68,7 @@ namespace quickbook
         template_scope const* parent_scope;
         template_scope const* parent_1_4;
         template_symbols symbols;
+        std::vector<template_symbol> arguments;
     };
 
     struct template_stack
@@ -87,11 +92,34 @@ namespace quickbook
                     boost::spirit::classic::match<> m = i->symbols.parse(scan);
                     if (m.length() > len) len = m.length();
                     scan.first = f;
+
+                    for (std::vector<template_symbol>::const_iterator
+                             it = i->arguments.begin(),
+                             end = i->arguments.end();
+                         it != end; ++it) {
+                        std::ptrdiff_t l = match_length(it->identifier, scan);
+                        if (l > len) len = l;
+                    }
                 }
                 if (len >= 0) scan.first = boost::next(f, len);
                 return len;
             }
 
+            // The length of 'identifier' if it's at the start of 'scan',
+            // -1 otherwise.
+            template <typename Scanner>
+            static std::ptrdiff_t match_length(
+                std::string const& identifier, Scanner const& scan)
+            {
+                typename Scanner::iterator_t it = scan.first;
+                std::string::const_iterator i = identifier.begin(),
+                                            end = identifier.end();
+                for (; i != end; ++i, ++it) {
+                    if (it == scan.last || *it != *i) return -1;
+                }
+                return static_cast<std::ptrdiff_t>(identifier.size());
+            }
+
             template_stack& ts;
 
           private:
@@ -107,6 +135,11 @@ namespace quickbook
         // If it doesn't have a scope, sets the symbol's scope to the current
         // scope.
         bool add(template_symbol const&);
+        // Add a template argument to the current scope.
+        bool add_argument(
+            std::string const& identifier,
+            value const& content,
+            template_scope const* parent);
         void push();
         void pop();
 
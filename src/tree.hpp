@@ -62,13 +62,16 @@ namespace quickbook
             }
         };
 
+        // Overload for nodes which aren't allocated with 'new'.
+        template <typename Node> void destroy_node(Node* n) { delete n; }
+
         template <typename Node> void delete_nodes(Node* n)
         {
             while (n) {
                 Node* to_delete = n;
                 n = n->next();
                 delete_nodes(to_delete->children());
-                delete (to_delete);
+                destroy_node(to_delete);
             }
         }
 
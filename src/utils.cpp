@@ -157,9 +157,23 @@ namespace quickbook
 
         void print_string(quickbook::string_view str, std::ostream& out)
         {
-            for (string_iterator cur = str.begin(); cur != str.end(); ++cur) {
-                print_char(*cur, out);
+            // Write the runs between characters that need escaping in one go.
+            string_iterator first = str.begin();
+            for (string_iterator cur = first; cur != str.end(); ++cur) {
+                switch (*cur) {
+                case '<':
+                case '>':
+                case '&':
+                case '"':
+                    out.write(first, cur - first);
+                    print_char(*cur, out);
+                    first = cur + 1;
+                    break;
+                default:
+                    break;
+                }
             }
+            out.write(first, str.end() - first);
         }
 
         std::string make_identifier(quickbook::string_view text)
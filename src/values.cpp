@@ -50,6 +50,10 @@ namespace quickbook
             UNDEFINED_ERROR();
         }
         std::string value_node::get_encoded() const { UNDEFINED_ERROR(); }
+        rope value_node::get_encoded_rope() const
+        {
+            return rope(get_encoded());
+        }
         value_node* value_node::get_list() const { UNDEFINED_ERROR(); }
 
         bool value_node::empty() const { return false; }
@@ -278,7 +282,7 @@ namespace quickbook
         struct encoded_value_impl : public value_node
         {
           public:
-            explicit encoded_value_impl(std::string const&, value::tag_type);
+            explicit encoded_value_impl(rope const&, value::tag_type);
 
           private:
             char const* type_name() const { return "encoded text"; }
@@ -286,11 +290,12 @@ namespace quickbook
             virtual ~encoded_value_impl();
             virtual value_node* clone() const;
             virtual std::string get_encoded() const;
+            virtual rope get_encoded_rope() const;
             virtual bool empty() const;
             virtual bool is_encoded() const;
             virtual bool equals(value_node*) const;
 
-            std::string value_;
+            rope value_;
         };
 
         struct qbk_value_impl : public value_node
@@ -330,7 +335,7 @@ namespace quickbook
                 file_ptr const&,
                 string_iterator,
                 string_iterator,
-                std::string const&,
+                rope const&,
                 value::tag_type);
 
             virtual ~encoded_qbk_value_impl();
@@ -339,6 +344,7 @@ namespace quickbook
             virtual string_iterator get_position() const;
             virtual quickbook::string_view get_quickbook() const;
             virtual std::string get_encoded() const;
+            virtual rope get_encoded_rope() const;
             virtual bool empty() const;
             virtual bool is_encoded() const;
             virtual bool equals(value_node*) const;
@@ -346,20 +352,20 @@ namespace quickbook
             file_ptr file_;
             string_iterator begin_;
             string_iterator end_;
-            std::string encoded_value_;
+            rope encoded_value_;
 
             friend quickbook::value quickbook::encoded_qbk_value(
                 file_ptr const&,
                 string_iterator,
                 string_iterator,
-                std::string const&,
+                rope const&,
                 quickbook::value::tag_type);
         };
 
         // encoded_value_impl
 
         encoded_value_impl::encoded_value_impl(
-            std::string const& val, value::tag_type tag)
+            rope const& val, value::tag_type tag)
             : value_node(tag), value_(val)
         {
         }
@@ -371,7 +377,12 @@ namespace quickbook
             return new encoded_value_impl(value_, tag_);
         }
 
-        std::string encoded_value_impl::get_encoded() const { return value_; }
+        std::string encoded_value_impl::get_encoded() const
+        {
+            return value_.str();
+        }
+
+        rope encoded_value_impl::get_encoded_rope() const { return value_; }
 
         bool encoded_value_impl::empty() const { return value_.empty(); }
 
@@ -380,7 +391,7 @@ namespace quickbook
         bool encoded_value_impl::equals(value_node* other) const
         {
             try {
-                return value_ == other->get_encoded();
+                return value_.str() == other->get_encoded();
             } catch (value_undefined_method&) {
                 return false;
             }
@@ -430,7 +441,7 @@ namespace quickbook
             file_ptr const& f,
             string_iterator begin,
             string_iterator end,
-            std::string const& encoded,
+            rope const& encoded,
             value::tag_type tag)
             : value_node(tag)
             , file_(f)
@@ -462,6 +473,11 @@ namespace quickbook
         }
 
         std::string encoded_qbk_value_impl::get_encoded() const
+        {
+            return encoded_value_.str();
+        }
+
+        rope encoded_qbk_value_impl::get_encoded_rope() const
         {
             return encoded_value_;
         }
@@ -501,7 +517,7 @@ namespace quickbook
 
     value encoded_value(std::string const& x, value::tag_type t)
     {
-        return value(new detail::encoded_value_impl(x, t));
+        return value(new detail::encoded_value_impl(rope(x), t));
     }
 
     value encoded_qbk_value(
@@ -510,6 +526,16 @@ namespace quickbook
         string_iterator y,
         std::string const& z,
         value::tag_type t)
+    {
+        return encoded_qbk_value(f, x, y, rope(z), t);
+    }
+
+    value encoded_qbk_value(
+        file_ptr const& f,
+        string_iterator x,
+        string_iterator y,
+        rope const& z,
+        value::tag_type t)
     {
         return value(new detail::encoded_qbk_value_impl(f, x, y, z, t));
     }
@@ -20,6 +20,7 @@
 #include <boost/scoped_ptr.hpp>
 #include "files.hpp"
 #include "fwd.hpp"
+#include "rope.hpp"
 #include "string_view.hpp"
 
 namespace quickbook
@@ -54,6 +55,7 @@ namespace quickbook
             virtual string_iterator get_position() const;
             virtual quickbook::string_view get_quickbook() const;
             virtual std::string get_encoded() const;
+            virtual rope get_encoded_rope() const;
             virtual int get_int() const;
 
             virtual bool check() const;
@@ -127,6 +129,12 @@ namespace quickbook
                 return value_->get_quickbook();
             }
             std::string get_encoded() const { return value_->get_encoded(); }
+            // Doesn't copy the text, so it's cheaper to write to a
+            // collector.
+            rope get_encoded_rope() const
+            {
+                return value_->get_encoded_rope();
+            }
             int get_int() const { return value_->get_int(); }
 
             // Equality is pretty inefficient. Not really designed for anything
@@ -287,6 +295,12 @@ namespace quickbook
         string_iterator,
         std::string const&,
         value::tag_type = value::default_tag);
+    value encoded_qbk_value(
+        file_ptr const&,
+        string_iterator,
+        string_iterator,
+        rope const&,
+        value::tag_type = value::default_tag);
 
     ////////////////////////////////////////////////////////////////////////////
     // Value Builder
@@ -0,0 +1,620 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#include "vfs.hpp"
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <set>
+#include <utility>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/unordered_map.hpp>
+#include "for.hpp"
+
+namespace quickbook
+{
+    std::size_t const file_system::no_limit;
+
+    file_system::~file_system() {}
+
+    //
+    // Native file system
+    //
+
+    namespace
+    {
+        struct native_file_system_impl : file_system
+        {
+            file_status status(fs::path const& path)
+            {
+                file_status result;
+                boost::system::error_code ec;
+                fs::file_status s = fs::status(path, ec);
+                if (ec || !fs::exists(s)) return result;
+
+                result.exists = true;
+                result.is_directory = fs::is_directory(s);
+                if (fs::is_regular_file(s)) {
+                    result.size = fs::file_size(path, ec);
+                    if (ec) result.size = 0;
+                }
+                result.modified = fs::last_write_time(path, ec);
+                if (ec) result.modified = 0;
+                return result;
+            }
+
+            bool read(
+                fs::path const& path,
+                std::string& contents,
+                std::size_t max_size)
+            {
+                fs::ifstream in(path, std::ios_base::binary);
+                if (!in) return false;
+
+                contents.clear();
+                char buffer[4096];
+                while (in && contents.size() < max_size) {
+                    std::size_t n = (std::min)(
+                        sizeof(buffer), max_size - contents.size());
+                    in.read(buffer, static_cast<std::streamsize>(n));
+                    contents.append(
+                        buffer, static_cast<std::size_t>(in.gcount()));
+                }
+
+                return !in.bad();
+            }
+
+            bool list(fs::path const& path, std::vector<entry>& entries)
+            {
+                boost::system::error_code ec;
+                if (!fs::is_directory(path, ec)) return false;
+
+                fs::directory_iterator dir_i(path, ec), dir_e;
+                if (ec) return false;
+
+                for (; dir_i != dir_e; dir_i.increment(ec)) {
+                    if (ec) return false;
+                    entry e;
+                    e.name = dir_i->path().filename();
+                    e.is_regular_file = fs::is_regular_file(dir_i->status());
+                    e.is_directory = fs::is_directory(dir_i->symlink_status());
+                    entries.push_back(e);
+                }
+
+                return !ec;
+            }
+
+            bool write(
+                fs::path const& path,
+                quickbook::string_view contents,
+                write_mode mode)
+            {
+                fs::ofstream out(
+                    path, mode == binary_mode
+                              ? std::ios_base::out | std::ios_base::binary
+                              : std::ios_base::out);
+                if (!out) return false;
+                out.write(
+                    contents.data(),
+                    static_cast<std::streamsize>(contents.size()));
+                out.close();
+                return !out.fail();
+            }
+
+            bool append(
+                fs::path const& path,
+                quickbook::string_view contents,
+                write_mode mode)
+            {
+                fs::ofstream out(
+                    path, mode == binary_mode ? std::ios_base::out |
+                                                    std::ios_base::app |
+                                                    std::ios_base::binary
+                                              : std::ios_base::out |
+                                                    std::ios_base::app);
+                if (!out) return false;
+                out.write(
+                    contents.data(),
+                    static_cast<std::streamsize>(contents.size()));
+                out.close();
+                return !out.fail();
+            }
+
+            bool create_directories(fs::path const& path)
+            {
+                boost::system::error_code ec;
+                fs::create_directories(path, ec);
+                return !ec;
+            }
+
+            bool rename(fs::path const& from, fs::path const& to)
+            {
+                boost::system::error_code ec;
+                fs::rename(from, to, ec);
+                return !ec;
+            }
+
+            bool remove(fs::path const& path)
+            {
+                boost::system::error_code ec;
+                return fs::remove(path, ec) && !ec;
+            }
+        };
+
+        native_file_system_impl native_files;
+        file_system* current_file_system = &native_files;
+    }
+
+    file_system& get_file_system() { return *current_file_system; }
+
+    file_system* set_file_system(file_system* f)
+    {
+        file_system* previous = current_file_system;
+        current_file_system = f ? f : &native_files;
+        return previous;
+    }
+
+    file_system& native_file_system() { return native_files; }
+
+    //
+    // update_file
+    //
+
+    namespace
+    {
+        // Text mode writes "\r\n" for each newline on windows.
+        bool translates_newlines(file_system::write_mode mode)
+        {
+#if defined(BOOST_WINDOWS_API)
+            return mode == file_system::text_mode;
+#else
+            (void)mode;
+            return false;
+#endif
+        }
+
+        // Does 'existing' have the same contents as 'contents' written in
+        // 'mode'?
+        bool same_contents(
+            quickbook::string_view existing,
+            quickbook::string_view contents,
+            file_system::write_mode mode)
+        {
+            if (!translates_newlines(mode)) return existing == contents;
+
+            quickbook::string_view::const_iterator it = existing.begin(),
+                                                   end = existing.end();
+            QUICKBOOK_FOR (char c, contents) {
+                if (c == '\n' && it != end && *it == '\r') ++it;
+                if (it == end || *it != c) return false;
+                ++it;
+            }
+            return it == end;
+        }
+    }
+
+    update_result update_file(
+        file_system& files,
+        fs::path const& path,
+        quickbook::string_view contents,
+        file_system::write_mode mode)
+    {
+        // Check the size first, to avoid reading a file that has obviously
+        // changed.
+        file_status status = files.status(path);
+        if (status.exists && !status.is_directory &&
+            (translates_newlines(mode) ? status.size >= contents.size()
+                                       : status.size == contents.size())) {
+            std::string existing;
+            if (files.read(path, existing) &&
+                same_contents(existing, contents, mode)) {
+                return file_unchanged;
+            }
+        }
+
+        // The temporary file needs a unique name, so that concurrent
+        // updates of the same file don't write to it at the same time. It's
+        // in the same directory so that it can be renamed over the file.
+        fs::path temp =
+            path.parent_path() / fs::unique_path("%%%%-%%%%-%%%%-%%%%.tmp");
+        if (!files.write(temp, contents, mode)) {
+            files.remove(temp);
+            return update_failed;
+        }
+        if (!files.rename(temp, path)) {
+            files.remove(temp);
+            return update_failed;
+        }
+        return file_written;
+    }
+
+    //
+    // Memory file system
+    //
+
+    namespace
+    {
+        // Remove '.' and '..' segments, so that each file has a single key.
+        fs::path lexical_key(fs::path const& path)
+        {
+            fs::path result;
+            QUICKBOOK_FOR (fs::path const& part, path) {
+                if (part == ".") {
+                    continue;
+                }
+                else if (
+                    part == ".." && !result.empty() &&
+                    result.filename() != ".." &&
+                    result != result.root_path()) {
+                    result.remove_filename();
+                }
+                else {
+                    result /= part;
+                }
+            }
+            return result;
+        }
+    }
+
+    struct memory_file_system::impl
+    {
+        struct file_entry
+        {
+            std::string contents;
+            std::time_t modified;
+        };
+
+        mutable std::mutex mutex;
+        std::map<fs::path, file_entry> files;
+        std::set<fs::path> directories;
+
+        void add_directories(fs::path path)
+        {
+            while (!path.empty()) {
+                if (!directories.insert(path).second) break;
+                path = path.parent_path();
+            }
+        }
+
+        void add(fs::path const& path, quickbook::string_view contents)
+        {
+            fs::path key = lexical_key(path);
+            file_entry& f = files[key];
+            f.contents.assign(contents.begin(), contents.end());
+            f.modified = std::time(0);
+            add_directories(key.parent_path());
+        }
+
+        void append(fs::path const& path, quickbook::string_view contents)
+        {
+            fs::path key = lexical_key(path);
+            file_entry& f = files[key];
+            f.contents.append(contents.begin(), contents.end());
+            f.modified = std::time(0);
+            add_directories(key.parent_path());
+        }
+    };
+
+    memory_file_system::memory_file_system() : impl_(new impl()) {}
+    memory_file_system::~memory_file_system() {}
+
+    void memory_file_system::add_file(
+        fs::path const& path, quickbook::string_view contents)
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->add(path, contents);
+    }
+
+    bool memory_file_system::get_file(
+        fs::path const& path, std::string& contents) const
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        std::map<fs::path, impl::file_entry>::const_iterator pos =
+            impl_->files.find(lexical_key(path));
+        if (pos == impl_->files.end()) return false;
+        contents = pos->second.contents;
+        return true;
+    }
+
+    file_status memory_file_system::status(fs::path const& path)
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        fs::path key = lexical_key(path);
+        file_status result;
+
+        std::map<fs::path, impl::file_entry>::const_iterator pos =
+            impl_->files.find(key);
+        if (pos != impl_->files.end()) {
+            result.exists = true;
+            result.size = pos->second.contents.size();
+            result.modified = pos->second.modified;
+        }
+        else if (key.empty() || impl_->directories.count(key)) {
+            result.exists = true;
+            result.is_directory = true;
+        }
+
+        return result;
+    }
+
+    bool memory_file_system::read(
+        fs::path const& path, std::string& contents, std::size_t max_size)
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        std::map<fs::path, impl::file_entry>::const_iterator pos =
+            impl_->files.find(lexical_key(path));
+        if (pos == impl_->files.end()) return false;
+        contents.assign(pos->second.contents, 0, max_size);
+        return true;
+    }
+
+    bool memory_file_system::list(
+        fs::path const& path, std::vector<entry>& entries)
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        fs::path key = lexical_key(path);
+        if (!key.empty() && !impl_->directories.count(key)) return false;
+
+        typedef std::pair<fs::path const, impl::file_entry> file_pair;
+        QUICKBOOK_FOR (file_pair const& f, impl_->files) {
+            if (f.first.parent_path() == key) {
+                entry e;
+                e.name = f.first.filename();
+                e.is_regular_file = true;
+                entries.push_back(e);
+            }
+        }
+
+        QUICKBOOK_FOR (fs::path const& d, impl_->directories) {
+            if (d.parent_path() == key) {
+                entry e;
+                e.name = d.filename();
+                e.is_directory = true;
+                entries.push_back(e);
+            }
+        }
+
+        return true;
+    }
+
+    bool memory_file_system::write(
+        fs::path const& path, quickbook::string_view contents, write_mode)
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->add(path, contents);
+        return true;
+    }
+
+    bool memory_file_system::append(
+        fs::path const& path, quickbook::string_view contents, write_mode)
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->append(path, contents);
+        return true;
+    }
+
+    bool memory_file_system::create_directories(fs::path const& path)
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->add_directories(lexical_key(path));
+        return true;
+    }
+
+    bool memory_file_system::rename(fs::path const& from, fs::path const& to)
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        std::map<fs::path, impl::file_entry>::iterator pos =
+            impl_->files.find(lexical_key(from));
+        if (pos == impl_->files.end()) return false;
+
+        fs::path key = lexical_key(to);
+        if (key == pos->first) return true;
+        impl_->files[key] = pos->second;
+        impl_->files.erase(pos);
+        impl_->add_directories(key.parent_path());
+        return true;
+    }
+
+    bool memory_file_system::remove(fs::path const& path)
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        return impl_->files.erase(lexical_key(path)) != 0;
+    }
+
+    //
+    // Caching file system
+    //
+
+    struct caching_file_system::impl
+    {
+        struct read_entry
+        {
+            bool found;
+            bool complete; // False if only the start has been read.
+            std::string contents;
+        };
+
+        struct list_entry
+        {
+            bool found;
+            std::vector<entry> entries;
+        };
+
+        explicit impl(file_system& base_) : base(base_) {}
+
+        // Forget anything about 'path' and the directories containing it,
+        // after it's been changed.
+        void invalidate(fs::path path)
+        {
+            reads.erase(path);
+            while (!path.empty()) {
+                statuses.erase(path);
+                lists.erase(path);
+                path = path.parent_path();
+            }
+            lists.erase(fs::path("."));
+            statuses.erase(fs::path("."));
+        }
+
+        file_system& base;
+        mutable std::mutex mutex;
+        statistics stats;
+        boost::unordered_map<fs::path, file_status> statuses;
+        boost::unordered_map<fs::path, read_entry> reads;
+        boost::unordered_map<fs::path, list_entry> lists;
+    };
+
+    caching_file_system::caching_file_system(file_system& base)
+        : impl_(new impl(base))
+    {
+    }
+
+    caching_file_system::~caching_file_system() {}
+
+    caching_file_system::statistics caching_file_system::get_statistics() const
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        return impl_->stats;
+    }
+
+    void caching_file_system::clear()
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->statuses.clear();
+        impl_->reads.clear();
+        impl_->lists.clear();
+    }
+
+    // The lock isn't held while calling the underlying file system, so
+    // that prefetch threads can read in parallel. If two threads miss the
+    // cache at the same time, both call it, and the last result is kept.
+
+    file_status caching_file_system::status(fs::path const& path)
+    {
+        std::unique_lock<std::mutex> lock(impl_->mutex);
+        boost::unordered_map<fs::path, file_status>::const_iterator pos =
+            impl_->statuses.find(path);
+        if (pos != impl_->statuses.end()) return pos->second;
+        ++impl_->stats.status;
+        lock.unlock();
+
+        file_status result = impl_->base.status(path);
+
+        lock.lock();
+        impl_->statuses[path] = result;
+        return result;
+    }
+
+    bool caching_file_system::read(
+        fs::path const& path, std::string& contents, std::size_t max_size)
+    {
+        std::unique_lock<std::mutex> lock(impl_->mutex);
+        boost::unordered_map<fs::path, impl::read_entry>::const_iterator pos =
+            impl_->reads.find(path);
+        if (pos != impl_->reads.end() &&
+            (!pos->second.found || pos->second.complete ||
+             (max_size != no_limit &&
+              pos->second.contents.size() >= max_size))) {
+            if (pos->second.found) {
+                contents.assign(pos->second.contents, 0, max_size);
+            }
+            return pos->second.found;
+        }
+        ++impl_->stats.reads;
+        lock.unlock();
+
+        impl::read_entry e;
+        e.found = impl_->base.read(path, e.contents, max_size);
+        e.complete = max_size == no_limit || e.contents.size() < max_size;
+
+        lock.lock();
+        impl_->stats.bytes_read += e.contents.size();
+        if (e.found) contents = e.contents;
+        bool found = e.found;
+        impl_->reads[path] = std::move(e);
+        return found;
+    }
+
+    bool caching_file_system::list(
+        fs::path const& path, std::vector<entry>& entries)
+    {
+        std::unique_lock<std::mutex> lock(impl_->mutex);
+        boost::unordered_map<fs::path, impl::list_entry>::const_iterator pos =
+            impl_->lists.find(path);
+        if (pos != impl_->lists.end()) {
+            entries.insert(
+                entries.end(), pos->second.entries.begin(),
+                pos->second.entries.end());
+            return pos->second.found;
+        }
+        ++impl_->stats.lists;
+        lock.unlock();
+
+        impl::list_entry e;
+        e.found = impl_->base.list(path, e.entries);
+
+        lock.lock();
+        entries.insert(entries.end(), e.entries.begin(), e.entries.end());
+        bool found = e.found;
+        impl_->lists[path] = std::move(e);
+        return found;
+    }
+
+    bool caching_file_system::write(
+        fs::path const& path, quickbook::string_view contents, write_mode mode)
+    {
+        bool result = impl_->base.write(path, contents, mode);
+
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        ++impl_->stats.writes;
+        impl_->stats.bytes_written += contents.size();
+        impl_->invalidate(path);
+        return result;
+    }
+
+    bool caching_file_system::append(
+        fs::path const& path, quickbook::string_view contents, write_mode mode)
+    {
+        bool result = impl_->base.append(path, contents, mode);
+
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        ++impl_->stats.writes;
+        impl_->stats.bytes_written += contents.size();
+        impl_->invalidate(path);
+        return result;
+    }
+
+    bool caching_file_system::create_directories(fs::path const& path)
+    {
+        bool result = impl_->base.create_directories(path);
+
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->invalidate(path);
+        return result;
+    }
+
+    bool caching_file_system::rename(fs::path const& from, fs::path const& to)
+    {
+        bool result = impl_->base.rename(from, to);
+
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->invalidate(from);
+        impl_->invalidate(to);
+        return result;
+    }
+
+    bool caching_file_system::remove(fs::path const& path)
+    {
+        bool result = impl_->base.remove(path);
+
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->invalidate(path);
+        return result;
+    }
+}
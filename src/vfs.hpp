@@ -0,0 +1,230 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+// Virtual file system
+//
+// Quickbook's file access (reading sources, templates and images, listing
+// directories for globs, writing output) goes through the current
+// 'file_system', so that documents can be converted from memory, and so
+// that access can be cached or counted in one place.
+//
+// Implementations have to be thread safe, as files are prefetched on
+// background threads.
+
+#if !defined(BOOST_QUICKBOOK_VFS_HPP)
+#define BOOST_QUICKBOOK_VFS_HPP
+
+#include <cstddef>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/filesystem/path.hpp>
+#include "string_view.hpp"
+
+namespace quickbook
+{
+    namespace fs = boost::filesystem;
+
+    struct file_status
+    {
+        file_status()
+            : exists(false), is_directory(false), size(0), modified(0)
+        {
+        }
+
+        bool exists;
+        bool is_directory;
+        boost::uintmax_t size;
+        std::time_t modified;
+    };
+
+    class file_system
+    {
+      public:
+        struct entry
+        {
+            entry() : name(), is_regular_file(false), is_directory(false) {}
+
+            fs::path name; // Just the filename
+            bool is_regular_file;
+            bool is_directory; // Not true for symbolic links
+        };
+
+        static std::size_t const no_limit = std::size_t(-1);
+
+        // Output written in text mode uses the platform's line endings.
+        enum write_mode
+        {
+            text_mode,
+            binary_mode
+        };
+
+        virtual ~file_system();
+
+        // A missing file isn't an error, it's just a status where 'exists'
+        // is false.
+        virtual file_status status(fs::path const&) = 0;
+
+        // Read the contents of a file, or just the start of it if
+        // 'max_size' is set. Returns false if it can't be read.
+        virtual bool read(
+            fs::path const&,
+            std::string& contents,
+            std::size_t max_size = no_limit) = 0;
+
+        // List the contents of a directory, returns false if it isn't one.
+        virtual bool list(fs::path const&, std::vector<entry>& entries) = 0;
+
+        // Write a file, replacing any existing contents. Returns false on
+        // failure.
+        virtual bool write(
+            fs::path const&,
+            quickbook::string_view,
+            write_mode mode = text_mode) = 0;
+
+        // Add to the end of a file, creating it if it doesn't exist. For
+        // output which is written in parts.
+        virtual bool append(
+            fs::path const&,
+            quickbook::string_view,
+            write_mode mode = text_mode) = 0;
+
+        // Create a directory and its parents if they don't exist.
+        virtual bool create_directories(fs::path const&) = 0;
+
+        // Rename a file, replacing 'to' if it exists.
+        virtual bool rename(fs::path const& from, fs::path const& to) = 0;
+
+        virtual bool remove(fs::path const&) = 0;
+    };
+
+    // The file system currently in use, the native one by default.
+    file_system& get_file_system();
+
+    // Returns the previous file system. Pass null to use the native file
+    // system.
+    file_system* set_file_system(file_system*);
+
+    file_system& native_file_system();
+
+    enum update_result
+    {
+        update_failed,
+        file_unchanged,
+        file_written
+    };
+
+    // Write a file, unless it already has exactly the same contents, in
+    // which case it's left alone so that its modification time doesn't
+    // change. The new contents are written to a uniquely named temporary
+    // file which is then renamed, so the file is never left partially
+    // written.
+    update_result update_file(
+        file_system&,
+        fs::path const&,
+        quickbook::string_view,
+        file_system::write_mode = file_system::text_mode);
+
+    // A file system that's just in memory. Paths are used lexically, after
+    // removing '.' and '..' segments, so relative and absolute paths are
+    // different files. Directories exist if they contain a file, or have
+    // been explicitly created.
+    class memory_file_system : public file_system
+    {
+      public:
+        memory_file_system();
+        ~memory_file_system();
+
+        void add_file(fs::path const&, quickbook::string_view);
+        bool get_file(fs::path const&, std::string& contents) const;
+
+        file_status status(fs::path const&);
+        bool read(
+            fs::path const&, std::string&, std::size_t max_size = no_limit);
+        bool list(fs::path const&, std::vector<entry>&);
+        bool write(
+            fs::path const&,
+            quickbook::string_view,
+            write_mode mode = text_mode);
+        bool append(
+            fs::path const&,
+            quickbook::string_view,
+            write_mode mode = text_mode);
+        bool create_directories(fs::path const&);
+        bool rename(fs::path const&, fs::path const&);
+        bool remove(fs::path const&);
+
+      private:
+        memory_file_system(memory_file_system const&);
+        memory_file_system& operator=(memory_file_system const&);
+
+        struct impl;
+        std::unique_ptr<impl> impl_;
+    };
+
+    // Remembers the results of 'status', 'read' and 'list' from another
+    // file system, for batch builds where the same files are checked many
+    // times. Writes go straight through, and update the cache.
+    class caching_file_system : public file_system
+    {
+      public:
+        // The number of calls passed on to the underlying file system.
+        struct statistics
+        {
+            statistics()
+                : status(0)
+                , reads(0)
+                , lists(0)
+                , writes(0)
+                , bytes_read(0)
+                , bytes_written(0)
+            {
+            }
+
+            unsigned status;
+            unsigned reads;
+            unsigned lists;
+            unsigned writes;
+            boost::uintmax_t bytes_read;
+            boost::uintmax_t bytes_written;
+        };
+
+        explicit caching_file_system(file_system& base);
+        ~caching_file_system();
+
+        statistics get_statistics() const;
+        void clear();
+
+        file_status status(fs::path const&);
+        bool read(
+            fs::path const&, std::string&, std::size_t max_size = no_limit);
+        bool list(fs::path const&, std::vector<entry>&);
+        bool write(
+            fs::path const&,
+            quickbook::string_view,
+            write_mode mode = text_mode);
+        bool append(
+            fs::path const&,
+            quickbook::string_view,
+            write_mode mode = text_mode);
+        bool create_directories(fs::path const&);
+        bool rename(fs::path const&, fs::path const&);
+        bool remove(fs::path const&);
+
+      private:
+        caching_file_system(caching_file_system const&);
+        caching_file_system& operator=(caching_file_system const&);
+
+        struct impl;
+        std::unique_ptr<impl> impl_;
+    };
+}
+
+#endif
@@ -7,6 +7,7 @@ http://www.boost.org/LICENSE_1_0.txt)
 =============================================================================*/
 
 #include "xml_parse.hpp"
+#include <cstring>
 #include "simple_parse.hpp"
 #include "stream.hpp"
 #include "utils.hpp"
@@ -15,6 +16,122 @@ namespace quickbook
 {
     namespace detail
     {
+        namespace
+        {
+            std::size_t const block_size = 65536;
+            std::size_t const alignment = alignof(std::max_align_t);
+
+            // 'memchr' is usually vectorized, so it's much faster than a
+            // loop for skipping over text.
+            string_iterator find_char(
+                string_iterator it, string_iterator end, char c)
+            {
+                void const* pos = std::memchr(it, c, end - it);
+                return pos ? static_cast<string_iterator>(pos) : end;
+            }
+
+            bool is_space(char c)
+            {
+                return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+            }
+
+            bool is_name_char(char c)
+            {
+                return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                       c == ':' || c == '-';
+            }
+
+            void skip_space(string_iterator& it, string_iterator end)
+            {
+                while (it != end && is_space(*it)) {
+                    ++it;
+                }
+            }
+        }
+
+        // xml_arena
+
+        xml_arena::xml_arena() : blocks_(), block_pos_(0), block_left_(0) {}
+        xml_arena::~xml_arena() {}
+
+        void* xml_arena::allocate(std::size_t size)
+        {
+            size = (size + alignment - 1) / alignment * alignment;
+
+            if (size > block_size / 4) {
+                // Too large to share a block, the current block is kept
+                // for later allocations.
+                blocks_.push_back(std::unique_ptr<char[]>(new char[size]));
+                return blocks_.back().get();
+            }
+
+            if (block_left_ < size) {
+                blocks_.push_back(
+                    std::unique_ptr<char[]>(new char[block_size]));
+                block_pos_ = blocks_.back().get();
+                block_left_ = block_size;
+            }
+
+            void* result = block_pos_;
+            block_pos_ += size;
+            block_left_ -= size;
+            return result;
+        }
+
+        quickbook::string_view xml_arena::store(quickbook::string_view x)
+        {
+            if (x.empty()) {
+                return quickbook::string_view();
+            }
+            char* data = static_cast<char*>(allocate(x.size()));
+            std::memcpy(data, x.data(), x.size());
+            return quickbook::string_view(data, x.size());
+        }
+
+        // xml_element
+
+        string_view xml_element::get_attribute(quickbook::string_view name)
+        {
+            xml_attribute* a = find_attribute(name);
+            if (!a) {
+                return string_view();
+            }
+            if (a->encoded) {
+                a->value = arena_->store(decode_string(a->value));
+                a->encoded = false;
+            }
+            return a->value;
+        }
+
+        string_view xml_element::set_attribute(
+            quickbook::string_view name, quickbook::string_view value)
+        {
+            xml_attribute* a = find_attribute(name);
+            if (!a) {
+                a = new (arena_->allocate(sizeof(xml_attribute)))
+                    xml_attribute();
+                a->name = arena_->store(name);
+                a->next = attributes_;
+                attributes_ = a;
+            }
+            a->value = arena_->store(value);
+            a->encoded = false;
+            return a->value;
+        }
+
+        void xml_element::add_encoded_attribute(
+            quickbook::string_view name, quickbook::string_view value)
+        {
+            xml_attribute* a =
+                new (arena_->allocate(sizeof(xml_attribute))) xml_attribute();
+            a->name = name;
+            a->value = value;
+            a->encoded = !value.empty() &&
+                         std::memchr(value.data(), '&', value.size()) != 0;
+            a->next = attributes_;
+            attributes_ = a;
+        }
+
         // write_xml_tree
 
         void write_xml_tree_impl(
@@ -40,7 +157,7 @@ namespace quickbook
             switch (node->type_) {
             case xml_element::element_node:
                 out += "Node: ";
-                out += node->name_;
+                out.append(node->name_.begin(), node->name_.end());
                 break;
             case xml_element::element_text:
                 out += "Text";
@@ -61,6 +178,7 @@ namespace quickbook
         // xml_parse
 
         void read_tag(
+            xml_arena&,
             xml_tree_builder&,
             string_iterator& it,
             string_iterator start,
@@ -81,7 +199,7 @@ namespace quickbook
         quickbook::string_view read_string(
             string_iterator& it, string_iterator end);
 
-        xml_tree xml_parse(quickbook::string_view source)
+        xml_tree xml_parse(xml_arena& arena, quickbook::string_view source)
         {
             typedef string_iterator iterator;
             iterator it = source.begin(), end = source.end();
@@ -90,10 +208,10 @@ namespace quickbook
 
             while (true) {
                 iterator start = it;
-                read_to(it, end, '<');
+                it = find_char(it, end, '<');
                 if (start != it) {
                     builder.add_element(xml_element::text_node(
-                        quickbook::string_view(start, it - start)));
+                        arena, quickbook::string_view(start, it - start)));
                 }
 
                 if (it == end) {
@@ -115,7 +233,7 @@ namespace quickbook
                     read_close_tag(builder, it, start, end);
                     break;
                 default:
-                    read_tag(builder, it, start, end);
+                    read_tag(arena, builder, it, start, end);
                     break;
                 }
             }
@@ -124,6 +242,7 @@ namespace quickbook
         }
 
         void read_tag(
+            xml_arena& arena,
             xml_tree_builder& builder,
             string_iterator& it,
             string_iterator start,
@@ -131,12 +250,12 @@ namespace quickbook
         {
             assert(it == start + 1 && it != end);
             quickbook::string_view name = read_tag_name(it, start, end);
-            xml_element* node = xml_element::node(name);
+            xml_element* node = xml_element::node(arena, name);
             builder.add_element(node);
 
             // Read attributes
             while (true) {
-                read_some_of(it, end, " \t\n\r");
+                skip_space(it, end);
                 if (it == end) {
                     throw xml_parse_error("Invalid tag", start);
                 }
@@ -147,7 +266,7 @@ namespace quickbook
                 }
                 if (*it == '/') {
                     ++it;
-                    read_some_of(it, end, " \t\n\r");
+                    skip_space(it, end);
                     if (it == end || *it != '>') {
                         throw xml_parse_error("Invalid tag", start);
                     }
@@ -156,7 +275,7 @@ namespace quickbook
                 }
                 quickbook::string_view attribute_name =
                     read_tag_name(it, start, end);
-                read_some_of(it, end, " \t\n\r");
+                skip_space(it, end);
                 if (it == end) {
                     throw xml_parse_error("Invalid tag", start);
                 }
@@ -165,9 +284,7 @@ namespace quickbook
                     ++it;
                     attribute_value = read_attribute_value(it, start, end);
                 }
-                node->set_attribute(
-                    attribute_name,
-                    quickbook::detail::decode_string(attribute_value));
+                node->add_encoded_attribute(attribute_name, attribute_value);
             }
         }
 
@@ -180,7 +297,7 @@ namespace quickbook
             assert(it == start + 1 && it != end && *it == '/');
             ++it;
             quickbook::string_view name = read_tag_name(it, start, end);
-            read_some_of(it, end, " \t\n\r");
+            skip_space(it, end);
             if (it == end || *it != '>') {
                 throw xml_parse_error("Invalid close tag", start);
             }
@@ -230,11 +347,17 @@ namespace quickbook
             ++it;
 
             if (read(it, end, "--")) {
-                if (read_past(it, end, "-->")) {
-                    return;
-                }
-                else {
-                    throw xml_parse_error("Invalid comment", start);
+                // Only a '-' can start the end of the comment, so jump
+                // between them rather than checking every character.
+                for (;;) {
+                    it = find_char(it, end, '-');
+                    if (it == end) {
+                        throw xml_parse_error("Invalid comment", start);
+                    }
+                    if (read(it, end, "-->")) {
+                        return;
+                    }
+                    ++it;
                 }
             }
 
@@ -260,11 +383,11 @@ namespace quickbook
         quickbook::string_view read_tag_name(
             string_iterator& it, string_iterator start, string_iterator end)
         {
-            read_some_of(it, end, " \t\n\r");
+            skip_space(it, end);
             string_iterator name_start = it;
-            read_some_of(
-                it, end,
-                "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ:-");
+            while (it != end && is_name_char(*it)) {
+                ++it;
+            }
             if (name_start == it) {
                 throw xml_parse_error("Invalid tag", start);
             }
@@ -274,8 +397,8 @@ namespace quickbook
         quickbook::string_view read_attribute_value(
             string_iterator& it, string_iterator start, string_iterator end)
         {
-            read_some_of(it, end, " \t\n\r");
-            if (*it == '"' || *it == '\'') {
+            skip_space(it, end);
+            if (it != end && (*it == '"' || *it == '\'')) {
                 return read_string(it, end);
             }
             else {
@@ -291,7 +414,7 @@ namespace quickbook
             string_iterator start = it;
             char deliminator = *it;
             ++it;
-            read_to(it, end, deliminator);
+            it = find_char(it, end, deliminator);
             if (it == end) {
                 throw xml_parse_error("Invalid string", start);
             }
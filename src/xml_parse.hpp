@@ -9,8 +9,10 @@ http://www.boost.org/LICENSE_1_0.txt)
 #if !defined(BOOST_QUICKBOOK_XML_PARSE_HPP)
 #define BOOST_QUICKBOOK_XML_PARSE_HPP
 
-#include <list>
-#include <string>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
 #include "string_view.hpp"
 #include "tree.hpp"
 
@@ -18,11 +20,46 @@ namespace quickbook
 {
     namespace detail
     {
+        class xml_arena;
+        struct xml_attribute;
         struct xml_element;
         typedef tree<xml_element> xml_tree;
         typedef tree_builder<xml_element> xml_tree_builder;
         struct xml_parse_error;
 
+        // Owns the memory for the nodes in xml trees, and any strings which
+        // aren't in the parsed source, so that they don't have to be
+        // allocated separately. Parsed text and names are views of the
+        // source, so both it and the arena must outlive the trees.
+        class xml_arena
+        {
+          public:
+            xml_arena();
+            ~xml_arena();
+
+            void* allocate(std::size_t);
+            // Copy a string into the arena.
+            quickbook::string_view store(quickbook::string_view);
+
+          private:
+            xml_arena(xml_arena const&);
+            xml_arena& operator=(xml_arena const&);
+
+            std::vector<std::unique_ptr<char[]> > blocks_;
+            char* block_pos_;
+            std::size_t block_left_;
+        };
+
+        struct xml_attribute
+        {
+            quickbook::string_view name;
+            quickbook::string_view value;
+            // The value is decoded when it's first needed, as most
+            // attributes don't contain entities, and many aren't used.
+            bool encoded;
+            xml_attribute* next;
+        };
+
         struct xml_element : tree_node<xml_element>
         {
             enum element_type
@@ -31,77 +68,67 @@ namespace quickbook
                 element_text,
                 element_html
             } type_;
-            std::string name_;
+            quickbook::string_view name_;
 
           private:
-            std::list<std::pair<std::string, std::string> > attributes_;
+            xml_arena* arena_;
+            // Most recently set first.
+            xml_attribute* attributes_;
 
           public:
-            std::string contents_;
-
-            explicit xml_element(element_type n) : type_(n) {}
-
-            explicit xml_element(element_type n, quickbook::string_view name)
-                : type_(n), name_(name.begin(), name.end())
+            // Text nodes are still encoded.
+            quickbook::string_view contents_;
+
+            xml_element(
+                xml_arena& a,
+                element_type n,
+                quickbook::string_view name = quickbook::string_view())
+                : type_(n), name_(name), arena_(&a), attributes_(0)
             {
             }
 
-            static xml_element* text_node(quickbook::string_view x)
+            // 'x' isn't copied.
+            static xml_element* text_node(
+                xml_arena& a, quickbook::string_view x)
             {
-                xml_element* n = new xml_element(element_text);
-                n->contents_.assign(x.begin(), x.end());
+                xml_element* n = new (a.allocate(sizeof(xml_element)))
+                    xml_element(a, element_text);
+                n->contents_ = x;
                 return n;
             }
 
-            static xml_element* html_node(quickbook::string_view x)
+            static xml_element* html_node(
+                xml_arena& a, quickbook::string_view x)
             {
-                xml_element* n = new xml_element(element_html);
-                n->contents_.assign(x.begin(), x.end());
+                xml_element* n = new (a.allocate(sizeof(xml_element)))
+                    xml_element(a, element_html);
+                n->contents_ = a.store(x);
                 return n;
             }
 
-            static xml_element* node(quickbook::string_view x)
+            // 'name' isn't copied.
+            static xml_element* node(xml_arena& a, quickbook::string_view name)
             {
-                return new xml_element(element_node, x);
+                return new (a.allocate(sizeof(xml_element)))
+                    xml_element(a, element_node, name);
             }
 
+            xml_arena& arena() const { return *arena_; }
+
             bool has_attribute(quickbook::string_view name)
             {
-                for (auto it = attributes_.begin(), end = attributes_.end();
-                     it != end; ++it) {
-                    if (name == it->first) {
-                        return true;
-                    }
-                }
-                return false;
+                return find_attribute(name) != 0;
             }
 
-            string_view get_attribute(quickbook::string_view name)
-            {
-                for (auto it = attributes_.begin(), end = attributes_.end();
-                     it != end; ++it) {
-                    if (name == it->first) {
-                        return it->second;
-                    }
-                }
-                return string_view();
-            }
+            string_view get_attribute(quickbook::string_view name);
 
             string_view set_attribute(
-                quickbook::string_view name, quickbook::string_view value)
-            {
-                for (auto it = attributes_.begin(), end = attributes_.end();
-                     it != end; ++it) {
-                    if (name == it->first) {
-                        it->second.assign(value.begin(), value.end());
-                        return it->second;
-                    }
-                }
+                quickbook::string_view name, quickbook::string_view value);
 
-                attributes_.push_back(
-                    std::make_pair(name.to_s(), value.to_s()));
-                return attributes_.back().second;
-            }
+            // Add an attribute while parsing, without checking if it's
+            // already set. Neither string is copied.
+            void add_encoded_attribute(
+                quickbook::string_view name, quickbook::string_view value);
 
             xml_element* get_child(quickbook::string_view name)
             {
@@ -113,8 +140,23 @@ namespace quickbook
 
                 return 0;
             }
+
+          private:
+            xml_attribute* find_attribute(quickbook::string_view name)
+            {
+                for (xml_attribute* it = attributes_; it; it = it->next) {
+                    if (name == it->name) {
+                        return it;
+                    }
+                }
+                return 0;
+            }
         };
 
+        // The memory belongs to the arena, and the nodes don't need to be
+        // destroyed, as they only contain views and pointers.
+        inline void destroy_node(xml_element*) {}
+
         struct xml_parse_error
         {
             char const* message;
@@ -127,7 +169,7 @@ namespace quickbook
         };
 
         void write_xml_tree(xml_element*);
-        xml_tree xml_parse(quickbook::string_view);
+        xml_tree xml_parse(xml_arena&, quickbook::string_view);
     }
 }
 
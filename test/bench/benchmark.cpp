@@ -0,0 +1,485 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+// Times the separate stages of converting a document:
+//
+//     parse_document     quickbook source to boostbook with id placeholders
+//     generate_ids       generating ids and replacing the placeholders
+//     post_process       pretty printing the boostbook
+//     xml_parse          parsing the boostbook, the first step of
+//                        boostbook_to_html
+//     boostbook_to_html  converting the boostbook to chunked html
+//     template_calls     parsing a document made up of template calls
+//
+// Each stage is run repeatedly until it's taken at least '--min-time'
+// seconds, and the average time and throughput are reported. Throughput is
+// measured against the size of the stage's input.
+//
+// To measure real documentation rather than the generated corpus, use
+// '--input', e.g. with 'doc/quickbook.qbk', which includes the rest of
+// quickbook's own documentation.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/scoped_ptr.hpp>
+#include "bb2html.hpp"
+#include "corpus.hpp"
+#include "document_state.hpp"
+#include "files.hpp"
+#include "grammar.hpp"
+#include "post_process.hpp"
+#include "quickbook.hpp"
+#include "state.hpp"
+#include "stream.hpp"
+#include "xml_parse.hpp"
+
+namespace quickbook
+{
+    namespace bench
+    {
+        struct benchmark
+        {
+            explicit benchmark(std::string const& name_)
+                : name(name_), bytes(0)
+            {
+            }
+            virtual ~benchmark() {}
+
+            // Called once before timing, sets 'bytes'.
+            virtual void setup() = 0;
+            virtual void run() = 0;
+
+            std::string name;
+            std::size_t bytes;
+        };
+
+        struct benchmark_result
+        {
+            std::string name;
+            unsigned long iterations;
+            double seconds; // Total time for all iterations
+            std::size_t bytes;
+
+            double time_per_iteration() const { return seconds / iterations; }
+
+            double bytes_per_second() const
+            {
+                return seconds > 0 ? bytes * iterations / seconds : 0;
+            }
+        };
+
+        benchmark_result run_benchmark(benchmark& b, double min_time)
+        {
+            typedef std::chrono::steady_clock clock;
+
+            b.setup();
+            // Warm up, also makes sure that nothing is still being loaded
+            // for the first time.
+            b.run();
+
+            benchmark_result result;
+            result.name = b.name;
+            result.iterations = 0;
+            result.seconds = 0;
+            result.bytes = b.bytes;
+
+            clock::time_point start = clock::now();
+            do {
+                b.run();
+                ++result.iterations;
+                result.seconds =
+                    std::chrono::duration<double>(clock::now() - start)
+                        .count();
+            } while (result.seconds < min_time);
+
+            return result;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        // The stages
+
+        struct document
+        {
+            fs::path input;
+            fs::path output_dir;
+            std::size_t input_size;
+
+            boost::scoped_ptr<document_state> ids;
+            std::string raw_boostbook; // With id placeholders
+            std::string boostbook;     // Ids replaced
+            std::string pretty_boostbook;
+        };
+
+        std::string parse(fs::path const& input, document_state& ids)
+        {
+            string_stream buffer;
+            quickbook::state state(input, input.parent_path(), buffer, ids);
+
+            state.dependencies.add_dependency(input);
+            state.current_file = load(input);
+            parse_file(state);
+
+            if (state.error_count) {
+                throw std::runtime_error("Error parsing document.");
+            }
+
+            return buffer.str();
+        }
+
+        struct parse_benchmark : benchmark
+        {
+            document& doc;
+
+            explicit parse_benchmark(document& d)
+                : benchmark("parse_document"), doc(d)
+            {
+            }
+
+            void setup() { bytes = doc.input_size; }
+
+            void run()
+            {
+                doc.ids.reset(new document_state());
+                doc.raw_boostbook = parse(doc.input, *doc.ids);
+            }
+        };
+
+        struct generate_ids_benchmark : benchmark
+        {
+            document& doc;
+
+            explicit generate_ids_benchmark(document& d)
+                : benchmark("generate_ids"), doc(d)
+            {
+            }
+
+            void setup()
+            {
+                if (!doc.ids) {
+                    doc.ids.reset(new document_state());
+                    doc.raw_boostbook = parse(doc.input, *doc.ids);
+                }
+                bytes = doc.raw_boostbook.size();
+            }
+
+            void run()
+            {
+                doc.boostbook = doc.ids->replace_placeholders(doc.raw_boostbook);
+            }
+        };
+
+        struct post_process_benchmark : benchmark
+        {
+            document& doc;
+
+            explicit post_process_benchmark(document& d)
+                : benchmark("post_process"), doc(d)
+            {
+            }
+
+            void setup()
+            {
+                if (doc.boostbook.empty()) {
+                    generate_ids_benchmark(doc).setup();
+                    doc.boostbook =
+                        doc.ids->replace_placeholders(doc.raw_boostbook);
+                }
+                bytes = doc.boostbook.size();
+            }
+
+            void run() { doc.pretty_boostbook = post_process(doc.boostbook); }
+        };
+
+        struct xml_parse_benchmark : benchmark
+        {
+            document& doc;
+
+            explicit xml_parse_benchmark(document& d)
+                : benchmark("xml_parse"), doc(d)
+            {
+            }
+
+            void setup()
+            {
+                if (doc.pretty_boostbook.empty()) {
+                    post_process_benchmark(doc).setup();
+                    doc.pretty_boostbook = post_process(doc.boostbook);
+                }
+                bytes = doc.pretty_boostbook.size();
+            }
+
+            void run()
+            {
+                detail::xml_arena arena;
+                detail::xml_tree tree =
+                    detail::xml_parse(arena, doc.pretty_boostbook);
+                if (!tree.root()) {
+                    throw std::runtime_error("Error parsing boostbook.");
+                }
+            }
+        };
+
+        struct html_benchmark : benchmark
+        {
+            document& doc;
+            detail::html_options options;
+
+            explicit html_benchmark(document& d)
+                : benchmark("boostbook_to_html"), doc(d)
+            {
+            }
+
+            void setup()
+            {
+                if (doc.pretty_boostbook.empty()) {
+                    post_process_benchmark(doc).setup();
+                    doc.pretty_boostbook = post_process(doc.boostbook);
+                }
+                bytes = doc.pretty_boostbook.size();
+
+                options.chunked_output = true;
+                options.home_path = doc.output_dir / "index.html";
+                options.pretty_print = true;
+            }
+
+            void run()
+            {
+                if (detail::boostbook_to_html(doc.pretty_boostbook, options)) {
+                    throw std::runtime_error("Error generating html.");
+                }
+            }
+        };
+
+        // Parses a document that's mostly template calls, with the arguments
+        // separated by whitespace, to measure the cost of calling templates
+        // and breaking up their arguments.
+        struct template_call_benchmark : benchmark
+        {
+            fs::path input;
+
+            explicit template_call_benchmark(fs::path const& input_)
+                : benchmark("template_calls"), input(input_)
+            {
+            }
+
+            void setup()
+            {
+                fs::ofstream out(input);
+                out << "[article Template calls [quickbook 1.5]]\n\n"
+                    << "[template one[a] (a)]\n"
+                    << "[template three[a b c] (a, b, c)]\n"
+                    << "[template five[a b c d e] (a, b, c, d, e)]\n\n";
+                for (unsigned i = 0; i < 2000; ++i) {
+                    out << "[one x" << i << "] [three x" << i << " y z] "
+                        << "[five x" << i << " y z [one w] v]\n";
+                    if (i % 10 == 9) out << "\n";
+                }
+                out.close();
+                if (out.fail()) {
+                    throw std::runtime_error(
+                        "Error writing: " + input.string());
+                }
+
+                bytes = fs::file_size(input);
+            }
+
+            void run()
+            {
+                document_state ids;
+                parse(input, ids);
+            }
+        };
+
+        ////////////////////////////////////////////////////////////////////////
+        // Reporting
+
+        void report(std::vector<benchmark_result> const& results)
+        {
+            std::printf(
+                "%-24s %15s %12s %15s\n", "Benchmark", "Time", "Iterations",
+                "Throughput");
+            std::printf("%s\n", std::string(69, '-').c_str());
+            for (std::vector<benchmark_result>::const_iterator it =
+                     results.begin();
+                 it != results.end(); ++it) {
+                std::printf(
+                    "%-24s %12.3f ms %12lu %10.3f MB/s\n", it->name.c_str(),
+                    it->time_per_iteration() * 1e3, it->iterations,
+                    it->bytes_per_second() / (1024 * 1024));
+            }
+        }
+
+        // Write the results in the same JSON format as google benchmark's
+        // '--benchmark_out', so that existing tools can compare runs.
+        void write_json(
+            fs::path const& path,
+            std::size_t input_size,
+            std::vector<benchmark_result> const& results)
+        {
+            fs::ofstream out(path);
+            if (!out) {
+                throw std::runtime_error("Error opening: " + path.string());
+            }
+
+            out << "{\n"
+                << "  \"context\": {\n"
+                << "    \"executable\": \"quickbook-benchmark\",\n"
+                << "    \"input_bytes\": " << input_size << "\n"
+                << "  },\n"
+                << "  \"benchmarks\": [";
+            for (std::vector<benchmark_result>::const_iterator it =
+                     results.begin();
+                 it != results.end(); ++it) {
+                out << (it == results.begin() ? "\n" : ",\n") << "    {\n"
+                    << "      \"name\": \"" << it->name << "\",\n"
+                    << "      \"iterations\": " << it->iterations << ",\n"
+                    << "      \"real_time\": "
+                    << it->time_per_iteration() * 1e6 << ",\n"
+                    << "      \"time_unit\": \"us\",\n"
+                    << "      \"bytes_per_second\": " << it->bytes_per_second()
+                    << "\n"
+                    << "    }";
+            }
+            out << "\n  ]\n"
+                << "}\n";
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    namespace fs = boost::filesystem;
+    using namespace quickbook::bench;
+
+    corpus_options options;
+    fs::path input;
+    fs::path work_dir;
+    fs::path json_out;
+    std::string filter;
+    double min_time = 1.0;
+    bool usage_error = false;
+
+    for (int i = 1; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--scale") == 0 && has_value) {
+            options.scale(std::atof(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--depth") == 0 && has_value) {
+            options.section_depth = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--input") == 0 && has_value) {
+            input = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--work-dir") == 0 && has_value) {
+            work_dir = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--min-time") == 0 && has_value) {
+            min_time = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--filter") == 0 && has_value) {
+            filter = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--json") == 0 && has_value) {
+            json_out = argv[++i];
+        }
+        else {
+            usage_error = true;
+        }
+    }
+
+    if (usage_error) {
+        std::cerr
+            << "Usage: benchmark [options]\n\n"
+            << "  --scale factor    Scale the generated corpus\n"
+            << "  --depth n         Depth of section nesting\n"
+            << "  --input file      Use an existing quickbook file instead\n"
+            << "                    of generating a corpus\n"
+            << "  --work-dir dir    Where to write the corpus and output\n"
+            << "  --min-time secs   Minimum time to run each benchmark\n"
+            << "  --filter text     Only run benchmarks containing 'text'\n"
+            << "  --json file       Also write the results as JSON\n";
+        return 1;
+    }
+
+    try {
+        fs::initial_path<fs::path>();
+        quickbook::detail::initialise_output();
+
+        // Use a fixed date, like '--debug', so the output is stable.
+        static tm timeinfo;
+        timeinfo.tm_year = 2000 - 1900;
+        timeinfo.tm_mon = 12 - 1;
+        timeinfo.tm_mday = 20;
+        timeinfo.tm_hour = 12;
+        timeinfo.tm_isdst = -1;
+        mktime(&timeinfo);
+        quickbook::current_time = &timeinfo;
+        quickbook::current_gm_time = &timeinfo;
+        quickbook::debug_mode = false;
+        quickbook::self_linked_headers = false;
+
+        if (work_dir.empty()) {
+            work_dir = fs::temp_directory_path() /
+                       fs::unique_path("quickbook-bench-%%%%-%%%%");
+        }
+        fs::create_directories(work_dir);
+
+        document doc;
+        doc.output_dir = work_dir / "html";
+
+        if (input.empty()) {
+            corpus c = generate_corpus(work_dir / "corpus", options);
+            doc.input = c.main_file;
+            doc.input_size = c.size;
+            std::cout << "Generated corpus: " << c.files.size() << " files, "
+                      << c.size << " bytes in " << work_dir.string() << "\n\n";
+        }
+        else {
+            doc.input = fs::absolute(input);
+            doc.input_size = fs::file_size(doc.input);
+        }
+        quickbook::image_location = doc.input.parent_path() / "html";
+
+        parse_benchmark parse(doc);
+        generate_ids_benchmark generate_ids(doc);
+        post_process_benchmark post_process(doc);
+        xml_parse_benchmark xml_parse(doc);
+        html_benchmark html(doc);
+        template_call_benchmark template_calls(work_dir / "template_calls.qbk");
+        benchmark* benchmarks[] = {&parse,     &generate_ids, &post_process,
+                                   &xml_parse, &html,         &template_calls};
+
+        std::vector<benchmark_result> results;
+        for (std::size_t i = 0; i < sizeof(benchmarks) / sizeof(*benchmarks);
+             ++i) {
+            if (benchmarks[i]->name.find(filter) != std::string::npos) {
+                results.push_back(run_benchmark(*benchmarks[i], min_time));
+            }
+        }
+
+        report(results);
+        if (!json_out.empty()) {
+            write_json(json_out, doc.input_size, results);
+        }
+    } catch (std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,373 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#include "corpus.hpp"
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+namespace quickbook
+{
+    namespace bench
+    {
+        corpus_options::corpus_options()
+            : section_depth(4)
+            , section_breadth(3)
+            , templates(1000)
+            , template_calls(5000)
+            , tables(50)
+            , table_rows(40)
+            , table_columns(5)
+            , code_blocks(150)
+            , code_lines(60)
+            , imports(4)
+            , import_snippets(100)
+            , snippet_lines(30)
+            , duplicate_headings(500)
+        {
+        }
+
+        namespace
+        {
+            unsigned scale_count(unsigned x, double factor)
+            {
+                double r = std::floor(x * factor + 0.5);
+                return x && r < 1 ? 1 : static_cast<unsigned>(r);
+            }
+        }
+
+        void corpus_options::scale(double factor)
+        {
+            templates = scale_count(templates, factor);
+            template_calls = scale_count(template_calls, factor);
+            tables = scale_count(tables, factor);
+            code_blocks = scale_count(code_blocks, factor);
+            imports = scale_count(imports, factor);
+            duplicate_headings = scale_count(duplicate_headings, factor);
+        }
+
+        namespace
+        {
+            // Distributes 'total' items evenly over 'slots' sections,
+            // returns how many go into section 'index'.
+            unsigned share(unsigned total, unsigned index, unsigned slots)
+            {
+                return static_cast<unsigned>(
+                    (static_cast<unsigned long long>(total) * (index + 1)) /
+                        slots -
+                    (static_cast<unsigned long long>(total) * index) / slots);
+            }
+
+            char const* const heading_titles[] = {"Overview", "Example",
+                                                  "Details", "Notes",
+                                                  "See also"};
+
+            struct corpus_writer
+            {
+                corpus_options const& options;
+                std::ostream& out;
+
+                unsigned section_count;
+                unsigned section_index;
+                std::vector<std::string> section_ids;
+
+                unsigned template_call;
+                unsigned table;
+                unsigned code_block;
+                unsigned snippet;
+                unsigned heading;
+
+                corpus_writer(corpus_options const& o, std::ostream& out_)
+                    : options(o)
+                    , out(out_)
+                    , section_count(0)
+                    , section_index(0)
+                    , section_ids()
+                    , template_call(0)
+                    , table(0)
+                    , code_block(0)
+                    , snippet(0)
+                    , heading(0)
+                {
+                    unsigned level = 1;
+                    for (unsigned i = 0; i < options.section_depth; ++i) {
+                        level *= options.section_breadth;
+                        section_count += level;
+                    }
+                    if (!section_count) {
+                        section_count = 1;
+                    }
+                }
+
+                void write_document()
+                {
+                    out << "[article Synthetic Corpus\n"
+                        << "    [quickbook 1.7]\n"
+                        << "    [id corpus]\n"
+                        << "]\n\n";
+
+                    for (unsigned i = 0; i < options.imports; ++i) {
+                        out << "[import import_" << i << ".cpp]\n";
+                    }
+                    out << "\n";
+
+                    for (unsigned i = 0; i < options.templates; ++i) {
+                        out << "[template tmpl_" << i << "[a b] Template " << i
+                            << " has *[a]* and /[b]/ with `code_" << i
+                            << "()` in it.]\n";
+                    }
+                    out << "\n"
+                        << "[def __boost__ [@http://www.boost.org/ Boost]]\n"
+                        << "[def __quickbook__ Quickbook]\n\n";
+
+                    if (options.section_depth && options.section_breadth) {
+                        std::string parent = "corpus";
+                        write_sections(parent, 1);
+                    }
+                    else {
+                        write_content();
+                    }
+                }
+
+                void write_sections(std::string const& parent, unsigned depth)
+                {
+                    for (unsigned i = 0; i < options.section_breadth; ++i) {
+                        std::ostringstream id;
+                        id << "s" << section_ids.size();
+                        std::string full_id = parent + "." + id.str();
+
+                        out << "[section:" << id.str() << " Section "
+                            << section_ids.size() << "]\n\n";
+                        section_ids.push_back(full_id);
+
+                        write_content();
+
+                        if (depth < options.section_depth) {
+                            write_sections(full_id, depth + 1);
+                        }
+
+                        out << "[endsect]\n\n";
+                    }
+                }
+
+                // Write this section's share of everything.
+                void write_content()
+                {
+                    unsigned index = section_index++;
+
+                    unsigned headings = share(
+                        options.duplicate_headings, index, section_count);
+                    unsigned calls =
+                        share(options.template_calls, index, section_count);
+                    unsigned tables =
+                        share(options.tables, index, section_count);
+                    unsigned code_blocks =
+                        share(options.code_blocks, index, section_count);
+                    unsigned snippets = share(
+                        options.imports * options.import_snippets, index,
+                        section_count);
+
+                    write_paragraph();
+
+                    // Spread everything else between the headings, so that
+                    // there's always at least one pass through the loop.
+                    unsigned parts = headings ? headings : 1;
+                    for (unsigned i = 0; i < parts; ++i) {
+                        if (i < headings) {
+                            out << "[heading "
+                                << heading_titles
+                                       [heading++ %
+                                        (sizeof(heading_titles) /
+                                         sizeof(heading_titles[0]))]
+                                << "]\n\n";
+                        }
+                        write_calls(share(calls, i, parts));
+                        for (unsigned j = share(tables, i, parts); j; --j) {
+                            write_table();
+                        }
+                        for (unsigned j = share(code_blocks, i, parts); j;
+                             --j) {
+                            write_code_block();
+                        }
+                        for (unsigned j = share(snippets, i, parts); j; --j) {
+                            out << "[snippet_" << snippet / options.import_snippets
+                                << "_" << snippet % options.import_snippets
+                                << "]\n\n";
+                            ++snippet;
+                        }
+                    }
+                }
+
+                void write_paragraph()
+                {
+                    out << "This is section " << (section_index - 1)
+                        << " of a synthetic __quickbook__ document, which "
+                           "is used for __boost__ benchmarks. It has some "
+                           "*bold*, /italic/ and `inline code` text, "
+                           "along with a [@http://www.example.com/ link]";
+                    if (section_ids.size() > 1) {
+                        out << " and a [link "
+                            << section_ids[(section_ids.size() - 1) / 2]
+                            << " link to an earlier section]";
+                    }
+                    out << ".\n\n";
+                }
+
+                void write_calls(unsigned count)
+                {
+                    if (!count || !options.templates) {
+                        return;
+                    }
+
+                    // Group the calls into paragraphs of up to 10 calls.
+                    for (unsigned i = 0; i < count; ++i) {
+                        unsigned t = template_call++ % options.templates;
+                        out << "Calling [tmpl_" << t << " first argument "
+                            << i << "..second argument] in a paragraph.";
+                        out << ((i % 10 == 9 || i + 1 == count) ? "\n\n" : "\n");
+                    }
+                }
+
+                void write_table()
+                {
+                    unsigned index = table++;
+
+                    out << "[table:table_" << index << " Table " << index
+                        << "\n";
+                    out << "    [";
+                    for (unsigned c = 0; c < options.table_columns; ++c) {
+                        out << "[Heading " << c << "]";
+                    }
+                    out << "]\n";
+                    for (unsigned r = 0; r < options.table_rows; ++r) {
+                        out << "    [";
+                        for (unsigned c = 0; c < options.table_columns; ++c) {
+                            out << "[Cell " << r << "," << c;
+                            if ((r + c) % 4 == 0) {
+                                out << " with *markup*";
+                            }
+                            else if ((r + c) % 4 == 2) {
+                                out << " with `code`";
+                            }
+                            out << "]";
+                        }
+                        out << "]\n";
+                    }
+                    out << "]\n\n";
+                }
+
+                void write_code_block()
+                {
+                    unsigned index = code_block++;
+
+                    switch (index % 3) {
+                    case 0:
+                        // Indented C++ code block.
+                        out << "[c++]\n\n";
+                        for (unsigned i = 0; i < options.code_lines; ++i) {
+                            out << "    std::vector<int> values_" << i
+                                << " = make_values(" << index << ", " << i
+                                << "); // Comment " << i << "\n";
+                        }
+                        out << "\n";
+                        break;
+                    case 1:
+                        out << "[python]\n\n``\n";
+                        for (unsigned i = 0; i < options.code_lines; i += 2) {
+                            out << "def function_" << i << "(x):  # Comment "
+                                << i << "\n"
+                                << "    return x * " << index << " + \"" << i
+                                << "\"\n";
+                        }
+                        out << "``\n\n";
+                        break;
+                    default:
+                        out << "[teletype]\n\n``\n";
+                        for (unsigned i = 0; i < options.code_lines; ++i) {
+                            out << "$ command --block " << index << " --line "
+                                << i << " <input> && echo 'done'\n";
+                        }
+                        out << "``\n\n";
+                        break;
+                    }
+                }
+            };
+
+            void write_import(
+                std::ostream& out, unsigned index, corpus_options const& options)
+            {
+                out << "// Synthetic import file " << index << "\n\n"
+                    << "#include <vector>\n\n";
+
+                for (unsigned s = 0; s < options.import_snippets; ++s) {
+                    // Some code that isn't in a snippet.
+                    out << "int unused_" << s << "(int x) { return x * " << s
+                        << "; }\n\n";
+
+                    out << "//[snippet_" << index << "_" << s << "\n"
+                        << "/*`Snippet " << index << "." << s
+                        << " with some *markup* in its description. */\n"
+                        << "int function_" << s << "(std::vector<int> const& "
+                        << "values)\n"
+                        << "{\n"
+                        << "    int total = 0; /*< A callout for snippet "
+                        << s << " >*/\n";
+                    for (unsigned i = 0; i < options.snippet_lines; ++i) {
+                        out << "    total += values[" << i << "] * " << s
+                            << "; // Line " << i << "\n";
+                    }
+                    out << "    return total;\n"
+                        << "}\n"
+                        << "//]\n\n";
+                }
+            }
+
+            void write_file(
+                corpus& result,
+                fs::path const& path,
+                std::string const& content)
+            {
+                fs::ofstream out(path, std::ios_base::binary);
+                out << content;
+                if (out.fail()) {
+                    throw std::runtime_error(
+                        "Error writing file: " + path.string());
+                }
+                result.files.push_back(path);
+                result.size += content.size();
+            }
+        }
+
+        corpus generate_corpus(
+            fs::path const& directory, corpus_options const& options)
+        {
+            corpus result;
+            result.size = 0;
+
+            fs::create_directories(directory);
+
+            for (unsigned i = 0; i < options.imports; ++i) {
+                std::ostringstream name;
+                name << "import_" << i << ".cpp";
+
+                std::ostringstream content;
+                write_import(content, i, options);
+                write_file(result, directory / name.str(), content.str());
+            }
+
+            std::ostringstream content;
+            corpus_writer(options, content).write_document();
+            result.main_file = directory / "corpus.qbk";
+            write_file(result, result.main_file, content.str());
+
+            return result;
+        }
+    }
+}
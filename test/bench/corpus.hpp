@@ -0,0 +1,64 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#if !defined(BOOST_QUICKBOOK_BENCH_CORPUS_HPP)
+#define BOOST_QUICKBOOK_BENCH_CORPUS_HPP
+
+// Generates large synthetic quickbook documents for the benchmarks.
+//
+// The documents are meant to stress the parts of quickbook that get slow on
+// real documentation: deeply nested sections, lots of templates and template
+// calls, big tables, long code blocks, imported code files and headings with
+// duplicate ids.
+
+#include <string>
+#include <vector>
+#include <boost/filesystem/path.hpp>
+
+namespace quickbook
+{
+    namespace bench
+    {
+        namespace fs = boost::filesystem;
+
+        struct corpus_options
+        {
+            corpus_options();
+
+            // Multiply all the counts (but not the section depth) by 'factor'.
+            void scale(double factor);
+
+            unsigned section_depth;   // Levels of nested sections
+            unsigned section_breadth; // Subsections in each section
+            unsigned templates;       // Template definitions
+            unsigned template_calls;  // Calls to those templates
+            unsigned tables;
+            unsigned table_rows;
+            unsigned table_columns;
+            unsigned code_blocks; // Split between C++, python and teletype
+            unsigned code_lines;  // Lines in each code block
+            unsigned imports;     // Imported C++ files
+            unsigned import_snippets; // Snippets in each imported file
+            unsigned snippet_lines;   // Lines of code in each snippet
+            unsigned duplicate_headings;
+        };
+
+        struct corpus
+        {
+            fs::path main_file;         // The document to process
+            std::vector<fs::path> files; // Every file written, including main
+            std::size_t size;            // Total size of the files in bytes
+        };
+
+        // Write a corpus into 'directory', which is created if necessary.
+        corpus generate_corpus(
+            fs::path const& directory, corpus_options const& options);
+    }
+}
+
+#endif
@@ -0,0 +1,59 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+// Writes a synthetic corpus to disk, so that it can be used to profile the
+// quickbook executable directly, e.g.
+//
+//     generate_corpus --scale 4 corpus-dir
+//     quickbook --output-format=html corpus-dir/corpus.qbk
+
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include "corpus.hpp"
+
+int main(int argc, char* argv[])
+{
+    quickbook::bench::corpus_options options;
+    char const* directory = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            options.scale(std::atof(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+            options.section_depth = std::atoi(argv[++i]);
+        }
+        else if (!directory && std::strncmp(argv[i], "--", 2) != 0) {
+            directory = argv[i];
+        }
+        else {
+            directory = 0;
+            break;
+        }
+    }
+
+    if (!directory) {
+        std::cerr << "Usage: generate_corpus [--scale factor] [--depth n] "
+                     "directory\n";
+        return 1;
+    }
+
+    try {
+        quickbook::bench::corpus c =
+            quickbook::bench::generate_corpus(directory, options);
+        std::cout << "Wrote " << c.files.size() << " files (" << c.size
+                  << " bytes), main file: " << c.main_file.string() << "\n";
+    } catch (std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,204 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#include "convert.hpp"
+#include <boost/detail/lightweight_test.hpp>
+
+bool contains(std::string const& x, char const* y)
+{
+    return x.find(y) != std::string::npos;
+}
+
+void boostbook_test()
+{
+    quickbook::convert_options options;
+    options.fixed_date = true;
+    options.defines.push_back("__greeting__=Hello");
+
+    quickbook::convert_result result = quickbook::convert(
+        "doc/test.qbk",
+        "[article Test\n[quickbook 1.7]]\n\n__greeting__ *world*\n", options);
+
+    BOOST_TEST(result.success);
+    BOOST_TEST(result.diagnostics.empty());
+    BOOST_TEST(contains(result.boostbook, "<article id=\"test\""));
+    BOOST_TEST(contains(result.boostbook, "Hello"));
+    BOOST_TEST(contains(result.boostbook, "<emphasis role=\"bold\">world"));
+    BOOST_TEST(result.html.empty());
+
+    // The same path with different contents.
+    result = quickbook::convert(
+        "doc/test.qbk", "[article Test\n[quickbook 1.7]]\n\nGoodbye\n",
+        options);
+
+    BOOST_TEST(result.success);
+    BOOST_TEST(contains(result.boostbook, "Goodbye"));
+    BOOST_TEST(!contains(result.boostbook, "Hello"));
+}
+
+void diagnostics_test()
+{
+    quickbook::convert_options options;
+    options.fixed_date = true;
+
+    quickbook::convert_result result = quickbook::convert(
+        "doc/test.qbk", "[article Test\n[quickbook 1.7]]\n\nText\n\n[endsect]\n",
+        options);
+
+    BOOST_TEST(!result.success);
+    BOOST_TEST(result.boostbook.empty());
+    BOOST_TEST_EQ(result.diagnostics.size(), 1u);
+    if (!result.diagnostics.empty()) {
+        quickbook::detail::diagnostic const& d = result.diagnostics.front();
+        BOOST_TEST(d.severity == quickbook::detail::diagnostic::error);
+        BOOST_TEST(d.file == "doc/test.qbk");
+        BOOST_TEST_EQ(d.line, 6);
+        BOOST_TEST(contains(d.message, "endsect"));
+        BOOST_TEST(!d.message.empty() && *d.message.rbegin() != '\n');
+    }
+}
+
+void html_test()
+{
+    quickbook::convert_options options;
+    options.fixed_date = true;
+    options.format = quickbook::convert_options::html;
+
+    quickbook::convert_result result = quickbook::convert(
+        "doc/test.qbk", "[article Test\n[quickbook 1.7]]\n\nSome text.\n",
+        options);
+
+    BOOST_TEST(result.success);
+    BOOST_TEST_EQ(result.html.size(), 1u);
+    BOOST_TEST(result.html.find("test.html") != result.html.end());
+    BOOST_TEST(contains(result.html["test.html"], "Some text."));
+}
+
+void memory_file_system_test()
+{
+    quickbook::memory_file_system files;
+    files.add_file("doc/templates.qbk", "[template thing[] Included]\n");
+    files.add_file("doc/parts/part.qbk", "Part text.\n");
+
+    quickbook::convert_options options;
+    options.fixed_date = true;
+    options.files = &files;
+
+    quickbook::convert_result result = quickbook::convert(
+        "doc/test.qbk",
+        "[article Test\n[quickbook 1.7]]\n\n"
+        "[import templates.qbk]\n[include parts/*.qbk]\n\n[thing]\n",
+        options);
+
+    BOOST_TEST(result.success);
+    BOOST_TEST(result.diagnostics.empty());
+    BOOST_TEST(contains(result.boostbook, "Part text."));
+    BOOST_TEST(contains(result.boostbook, "Included"));
+    BOOST_TEST(contains(result.dependencies, "doc/parts/part.qbk"));
+    BOOST_TEST(&quickbook::get_file_system() != &files);
+
+    // Not found in the native file system.
+    options.files = 0;
+    result = quickbook::convert(
+        "doc/test.qbk",
+        "[article Test\n[quickbook 1.7]]\n\n[include parts/part.qbk]\n",
+        options);
+    BOOST_TEST(!result.success);
+}
+
+// Files and snippets are cached while a document is converted, but not
+// between conversions.
+void changed_file_test()
+{
+    quickbook::memory_file_system files;
+    files.add_file("doc/a.cpp", "//[snippet\nint old_code;\n//]\n");
+
+    quickbook::convert_options options;
+    options.fixed_date = true;
+    options.files = &files;
+
+    char const* source =
+        "[article Test\n[quickbook 1.7]]\n\n[import a.cpp]\n\n[snippet]\n";
+
+    quickbook::convert_result result =
+        quickbook::convert("doc/test.qbk", source, options);
+    BOOST_TEST(result.success);
+    BOOST_TEST(contains(result.boostbook, "old_code"));
+
+    files.add_file("doc/a.cpp", "//[snippet\nint new_code;\n//]\n");
+    result = quickbook::convert("doc/test.qbk", source, options);
+    BOOST_TEST(result.success);
+    BOOST_TEST(contains(result.boostbook, "new_code"));
+    BOOST_TEST(!contains(result.boostbook, "old_code"));
+}
+
+// An svg's size is read again by the next conversion, even if the file was
+// replaced within the same second.
+void changed_svg_test()
+{
+    quickbook::memory_file_system files;
+    files.add_file("doc/html/a.svg", "<svg width=\"10\" height=\"20\">");
+
+    quickbook::convert_options options;
+    options.fixed_date = true;
+    options.files = &files;
+
+    char const* source = "[article Test\n[quickbook 1.7]]\n\n[$a.svg]\n";
+
+    quickbook::convert_result result =
+        quickbook::convert("doc/test.qbk", source, options);
+    BOOST_TEST(result.success);
+    BOOST_TEST(contains(result.boostbook, "contentwidth=\"10\""));
+
+    files.add_file("doc/html/a.svg", "<svg width=\"99\" height=\"20\">");
+    result = quickbook::convert("doc/test.qbk", source, options);
+    BOOST_TEST(result.success);
+    BOOST_TEST(contains(result.boostbook, "contentwidth=\"99\""));
+}
+
+// An include in a comment is still prefetched, but never loaded, so it
+// mustn't be used by a later conversion.
+void prefetch_test()
+{
+    quickbook::memory_file_system files;
+
+    quickbook::convert_options options;
+    options.fixed_date = true;
+    options.files = &files;
+
+    for (int i = 0; i < 10; ++i) {
+        files.add_file("doc/a.qbk", "Old text.\n");
+        quickbook::convert_result result = quickbook::convert(
+            "doc/test.qbk",
+            "[article Test\n[quickbook 1.7]]\n\n[/ [include a.qbk] ]\n",
+            options);
+        BOOST_TEST(result.success);
+
+        files.add_file("doc/a.qbk", "New text.\n");
+        result = quickbook::convert(
+            "doc/test.qbk",
+            "[article Test\n[quickbook 1.7]]\n\n[include a.qbk]\n",
+            options);
+        BOOST_TEST(result.success);
+        BOOST_TEST(contains(result.boostbook, "New text."));
+        BOOST_TEST(!contains(result.boostbook, "Old text."));
+    }
+}
+
+int main()
+{
+    boostbook_test();
+    diagnostics_test();
+    html_test();
+    memory_file_system_test();
+    changed_file_test();
+    changed_svg_test();
+    prefetch_test();
+
+    return boost::report_errors();
+}
@@ -6,6 +6,7 @@
     http://www.boost.org/LICENSE_1_0.txt)
 =============================================================================*/
 
+#include <iostream>
 #include <boost/detail/lightweight_test.hpp>
 #include "glob.hpp"
 
@@ -91,6 +92,134 @@ void glob_tests()
     BOOST_TEST(!quickbook::glob("1234*1234*1234", "12341231231234123123123"));
 }
 
+void recursive_glob_tests()
+{
+    BOOST_TEST(quickbook::glob("**", "a"));
+    BOOST_TEST(quickbook::glob("**", "a/b/c"));
+    BOOST_TEST(quickbook::glob("**/c", "c"));
+    BOOST_TEST(quickbook::glob("**/c", "a/b/c"));
+    BOOST_TEST(!quickbook::glob("**/c", "a/b/cd"));
+    BOOST_TEST(quickbook::glob("**/*.qbk", "a/b.qbk"));
+    BOOST_TEST(!quickbook::glob("**/*.qbk", "a/b.qbk/c"));
+    BOOST_TEST(quickbook::glob("a/**", "a/b"));
+    BOOST_TEST(quickbook::glob("a/**", "a/b/c"));
+    BOOST_TEST(!quickbook::glob("a/**", "b/c"));
+    BOOST_TEST(quickbook::glob("a/**/c", "a/c"));
+    BOOST_TEST(quickbook::glob("a/**/c", "a/b/c"));
+    BOOST_TEST(quickbook::glob("a/**/c", "a/b/b/c"));
+    BOOST_TEST(!quickbook::glob("a/**/c", "a/b/d"));
+    BOOST_TEST(quickbook::glob("a/**/b/**/c", "a/b/c"));
+    BOOST_TEST(quickbook::glob("a/**/b/**/c", "a/x/b/y/z/c"));
+    BOOST_TEST(!quickbook::glob("a/**/b/**/c", "a/x/y/c"));
+
+    // '*' doesn't match slashes in paths.
+    BOOST_TEST(quickbook::glob("a/*", "a/b"));
+    BOOST_TEST(!quickbook::glob("a/*", "a/b/c"));
+    BOOST_TEST(!quickbook::glob("*", "a/b"));
+    BOOST_TEST(quickbook::glob("*/*", "a/b"));
+}
+
+// Check that compiled_glob gives the same results as glob.
+void compiled_glob_tests()
+{
+    char const* patterns[] = {"",
+                              "*",
+                              "*b",
+                              "*b*",
+                              "b*",
+                              "hello.txt",
+                              "*world.txt",
+                              "hello*",
+                              "*world*",
+                              "?",
+                              "a?",
+                              "?bc",
+                              "a?c",
+                              "[a]",
+                              "[^a]",
+                              "[a-z]",
+                              "[^a-z]",
+                              "[-a]",
+                              "[^-a]",
+                              "[a-]",
+                              "[^a-]",
+                              "[a-ce-f]",
+                              "[^a-ce-f]",
+                              "a[a-c]c",
+                              "*[b]*",
+                              "[\\]]",
+                              "[^\\]]",
+                              "\\*",
+                              "\\?*",
+                              "b*ana",
+                              "b*a*a",
+                              "1234*1234*1234",
+                              "*.qbk",
+                              "*.[ch]pp",
+                              "**",
+                              "**/c",
+                              "**/*.qbk",
+                              "a/**",
+                              "a/*",
+                              "*/*",
+                              "a/**/c",
+                              "a/**/b/**/c"};
+
+    char const* filenames[] = {"",
+                               "a",
+                               "b",
+                               "-",
+                               "]",
+                               "*",
+                               "ab",
+                               "bab",
+                               "abc",
+                               "bc",
+                               "aac",
+                               "abcd",
+                               "hello.txt",
+                               "helloworld.txt",
+                               "banana",
+                               "bandana",
+                               "123412341234",
+                               "1234123341234",
+                               "123412312312341231231234",
+                               "a.qbk",
+                               "a.qbk.bak",
+                               "file.cpp",
+                               "file.hpp",
+                               "file.xpp",
+                               "\xc3\xa9",
+                               "a/b",
+                               "a/c",
+                               "a/b/c",
+                               "a/b.qbk",
+                               "a/x/b/y/z/c",
+                               "b/c"};
+
+    for (std::size_t i = 0; i < sizeof(patterns) / sizeof(*patterns); ++i) {
+        quickbook::compiled_glob compiled(patterns[i]);
+
+        for (std::size_t j = 0; j < sizeof(filenames) / sizeof(*filenames);
+             ++j) {
+            bool expected = quickbook::glob(patterns[i], filenames[j]);
+            if (compiled.match(filenames[j]) != expected) {
+                BOOST_ERROR("compiled_glob doesn't match glob");
+                std::cerr << "Pattern: '" << patterns[i] << "', filename: '"
+                          << filenames[j] << "'\n";
+            }
+        }
+    }
+
+    BOOST_TEST_THROWS(quickbook::compiled_glob("["), quickbook::glob_error);
+    BOOST_TEST_THROWS(
+        quickbook::compiled_glob("[a-z"), quickbook::glob_error);
+    BOOST_TEST_THROWS(quickbook::compiled_glob("]"), quickbook::glob_error);
+    BOOST_TEST_THROWS(quickbook::compiled_glob("[]"), quickbook::glob_error);
+    BOOST_TEST_THROWS(quickbook::compiled_glob("a**"), quickbook::glob_error);
+    BOOST_TEST_THROWS(quickbook::compiled_glob("\\"), quickbook::glob_error);
+}
+
 void invalid_glob_tests()
 {
     // Note that glob only throws an exception when the pattern matches up to
@@ -111,7 +240,8 @@ void invalid_glob_tests()
     BOOST_TEST_THROWS(quickbook::glob("[]", "a"), quickbook::glob_error);
     BOOST_TEST_THROWS(quickbook::glob("[[]", "a"), quickbook::glob_error);
     BOOST_TEST_THROWS(quickbook::glob("[]]", "a"), quickbook::glob_error);
-    BOOST_TEST_THROWS(quickbook::glob("**", "a"), quickbook::glob_error);
+    BOOST_TEST_THROWS(quickbook::glob("a**", "ab"), quickbook::glob_error);
+    BOOST_TEST_THROWS(quickbook::glob("**b", "ab"), quickbook::glob_error);
     BOOST_TEST_THROWS(quickbook::glob("[/]", "a"), quickbook::glob_error);
     BOOST_TEST_THROWS(quickbook::glob("[\\/]", "a"), quickbook::glob_error);
     BOOST_TEST_THROWS(quickbook::glob("[ -/]", "a"), quickbook::glob_error);
@@ -128,6 +258,11 @@ void check_glob_tests()
     BOOST_TEST(quickbook::check_glob("[x]"));
     BOOST_TEST(quickbook::check_glob("abc[x]"));
     BOOST_TEST(quickbook::check_glob("[x]abd"));
+    BOOST_TEST(quickbook::check_glob("**"));
+    BOOST_TEST(quickbook::check_glob("**/a"));
+    BOOST_TEST(quickbook::check_glob("a/**"));
+    BOOST_TEST(quickbook::check_glob("a/**/b"));
+    BOOST_TEST(quickbook::check_glob("\\**"));
     BOOST_TEST_THROWS(quickbook::check_glob("["), quickbook::glob_error);
     BOOST_TEST_THROWS(quickbook::check_glob("[^"), quickbook::glob_error);
     BOOST_TEST_THROWS(quickbook::check_glob("[xyz"), quickbook::glob_error);
@@ -144,7 +279,10 @@ void check_glob_tests()
     BOOST_TEST_THROWS(quickbook::check_glob("[]"), quickbook::glob_error);
     BOOST_TEST_THROWS(quickbook::check_glob("[[]"), quickbook::glob_error);
     BOOST_TEST_THROWS(quickbook::check_glob("[]]"), quickbook::glob_error);
-    BOOST_TEST_THROWS(quickbook::check_glob("**"), quickbook::glob_error);
+    BOOST_TEST_THROWS(quickbook::check_glob("a**"), quickbook::glob_error);
+    BOOST_TEST_THROWS(quickbook::check_glob("**a"), quickbook::glob_error);
+    BOOST_TEST_THROWS(quickbook::check_glob("a/**b"), quickbook::glob_error);
+    BOOST_TEST_THROWS(quickbook::check_glob("a/***"), quickbook::glob_error);
     BOOST_TEST_THROWS(quickbook::check_glob("[/]"), quickbook::glob_error);
     BOOST_TEST_THROWS(quickbook::check_glob("[\\/]"), quickbook::glob_error);
     BOOST_TEST_THROWS(quickbook::check_glob("[ -/]"), quickbook::glob_error);
@@ -156,6 +294,8 @@ void check_glob_tests()
 int main()
 {
     glob_tests();
+    recursive_glob_tests();
+    compiled_glob_tests();
     invalid_glob_tests();
     check_glob_tests();
 
@@ -0,0 +1,55 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#include "gzip.hpp"
+#include <boost/detail/lightweight_test.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+namespace io = boost::iostreams;
+
+std::string decompress(std::string const& x)
+{
+    std::string result;
+    io::filtering_istream in;
+    in.push(io::gzip_decompressor());
+    in.push(io::array_source(x.data(), x.size()));
+    io::copy(in, io::back_inserter(result));
+    return result;
+}
+
+void round_trip_test(std::string const& x)
+{
+    std::string compressed = quickbook::detail::gzip_compress(x);
+    BOOST_TEST(compressed.size() >= 18);
+    BOOST_TEST_EQ(compressed.substr(0, 2), "\x1f\x8b");
+    BOOST_TEST_EQ(decompress(compressed), x);
+
+    // No timestamp, so the output is stable.
+    BOOST_TEST_EQ(quickbook::detail::gzip_compress(x), compressed);
+}
+
+int main()
+{
+    round_trip_test("");
+    round_trip_test("<html></html>\n");
+
+    std::string page;
+    for (int i = 0; i < 1000; ++i) {
+        page += "<p>Paragraph ";
+        page += static_cast<char>('0' + i % 10);
+        page += "</p>\n";
+    }
+    round_trip_test(page);
+    BOOST_TEST(quickbook::detail::gzip_compress(page).size() < page.size() / 4);
+
+    return boost::report_errors();
+}
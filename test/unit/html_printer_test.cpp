@@ -0,0 +1,113 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#include "html_printer.hpp"
+#include <boost/detail/lightweight_test.hpp>
+#include "post_process.hpp"
+
+// Pretty print 'html', writing it in pieces of 'size' characters, and
+// check that it matches 'post_process'.
+void check_pretty_print(std::string const& html, std::size_t size)
+{
+    quickbook::detail::html_printer printer;
+    quickbook::detail::start_pretty_print(printer);
+    for (std::size_t i = 0; i < html.size(); i += size) {
+        quickbook::detail::print_html(
+            printer, quickbook::string_view(html.data() + i,
+                                            std::min(size, html.size() - i)));
+    }
+    BOOST_TEST(quickbook::detail::end_pretty_print(printer));
+    BOOST_TEST_EQ(printer.html, quickbook::post_process(html, -1, -1, true));
+}
+
+void markup_test()
+{
+    std::string html =
+        "<!DOCTYPE html>\n<html><head></head><body>"
+        "<div class=\"x\"><p>Some <b>bold</b> text, "
+        "and a <a href=\"#a\">link</a>.</p>"
+        "<!-- comment --><hr/><p>A long paragraph which will have to be "
+        "broken over several lines, because it's longer than eighty "
+        "characters.</p>"
+        "<pre class=\"programlisting\">int main()\r\n{\n"
+        "    <span class=\"keyword\">return</span> 0;  \n}\n</pre>\n\n"
+        "<ul><li>One</li><li><!--quickbook-escape-prefix--> <raw>  "
+        "<!--quickbook-escape-postfix--> Two</li></ul>"
+        "</div></body></html>";
+
+    for (std::size_t size = 1; size <= 8; ++size) {
+        check_pretty_print(html, size);
+    }
+    check_pretty_print(html, html.size());
+}
+
+void tag_test()
+{
+    // Tags written with 'tag_start' etc. are printed without being
+    // tokenized.
+    quickbook::detail::html_printer printer;
+    quickbook::detail::start_pretty_print(printer);
+    quickbook::detail::open_tag(printer, "div");
+    quickbook::detail::tag_start(printer, "p");
+    quickbook::detail::tag_attribute(printer, "class", "a&b");
+    quickbook::detail::tag_end(printer);
+    quickbook::detail::print_html(printer, "Text ");
+    quickbook::detail::tag_start(printer, "br");
+    quickbook::detail::tag_end_self_close(printer);
+    quickbook::detail::close_tag(printer, "p");
+    quickbook::detail::open_tag(printer, "pre");
+    quickbook::detail::open_tag(printer, "span");
+    quickbook::detail::print_html(printer, "code\n");
+    quickbook::detail::close_tag(printer, "span");
+    quickbook::detail::close_tag(printer, "pre");
+    quickbook::detail::close_tag(printer, "div");
+    BOOST_TEST(quickbook::detail::end_pretty_print(printer));
+    BOOST_TEST_EQ(
+        printer.html, "<div>\n"
+                      "  <p class=\"a&amp;b\">\n"
+                      "    Text <br/>\n"
+                      "  </p>\n"
+                      "<pre><span>code\n"
+                      "</span></pre>\n"
+                      "</div>\n");
+    BOOST_TEST_EQ(
+        printer.html,
+        quickbook::post_process(
+            "<div><p class=\"a&amp;b\">Text <br/></p>"
+            "<pre><span>code\n</span></pre></div>",
+            -1, -1, true));
+
+    // Without pretty printing the html is written as is.
+    quickbook::detail::html_printer plain;
+    quickbook::detail::open_tag(plain, "p");
+    quickbook::detail::print_html(plain, "Text");
+    quickbook::detail::close_tag(plain, "p");
+    BOOST_TEST(quickbook::detail::end_pretty_print(plain));
+    BOOST_TEST_EQ(plain.html, "<p>Text</p>");
+}
+
+void malformed_test()
+{
+    quickbook::detail::html_printer printer;
+    quickbook::detail::start_pretty_print(printer);
+    quickbook::detail::print_html(printer, "<p></p></p>");
+    BOOST_TEST(!quickbook::detail::end_pretty_print(printer));
+
+    quickbook::detail::start_pretty_print(printer);
+    quickbook::detail::print_html(printer, "<p>Text <a href=");
+    BOOST_TEST(!quickbook::detail::end_pretty_print(printer));
+}
+
+int main()
+{
+    markup_test();
+    tag_test();
+    malformed_test();
+
+    return boost::report_errors();
+}
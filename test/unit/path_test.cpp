@@ -190,10 +190,88 @@ void path_difference_tests()
         path_difference(path("b/c/../../a"), path("d/f/../../../x/a/b"), true));
 }
 
+std::string lexical_difference(char const* base, char const* path)
+{
+    quickbook::split_path b = quickbook::split_absolute_path("x");
+    b.parts.pop_back();
+    quickbook::split_path p = b;
+    b.append(base);
+    p.append(path);
+    return quickbook::lexical_path_difference(b, p);
+}
+
+void lexical_path_difference_tests()
+{
+    BOOST_TEST_EQ(".", lexical_difference("", ""));
+    BOOST_TEST_EQ(".", lexical_difference("a", "a"));
+    BOOST_TEST_EQ(".", lexical_difference("a/../b", "b"));
+    BOOST_TEST_EQ(".", lexical_difference("a/./", "a"));
+    BOOST_TEST_EQ("..", lexical_difference("a", ""));
+    BOOST_TEST_EQ("a", lexical_difference("", "a"));
+    BOOST_TEST_EQ("b", lexical_difference("a", "a/b"));
+    BOOST_TEST_EQ("b", lexical_difference("a", "a//b/"));
+    BOOST_TEST_EQ("../a/b", lexical_difference("c", "a/b"));
+    BOOST_TEST_EQ("../../x/a/b", lexical_difference("b/c", "x/a/b"));
+    BOOST_TEST_EQ("b", lexical_difference("a/c/..", "a/b"));
+    BOOST_TEST_EQ(
+        "../../x/a/b", lexical_difference("b/c/../../a", "d/f/../../../x/a/b"));
+
+    quickbook::split_path root = quickbook::split_absolute_path("x");
+    root.parts.clear();
+    quickbook::split_path other = root;
+    other.root = "//example.com/";
+    other.append("a/b");
+    BOOST_TEST_EQ(
+        "//example.com/a/b", quickbook::lexical_path_difference(root, other));
+    other.parts.clear();
+    BOOST_TEST_EQ(
+        "//example.com/", quickbook::lexical_path_difference(root, other));
+}
+
+void interned_path_tests()
+{
+    using boost::filesystem::path;
+    using quickbook::interned_path;
+
+    interned_path empty;
+    BOOST_TEST(empty.empty());
+    BOOST_TEST(empty == interned_path(path()));
+
+    interned_path a1("a/b"), a2(path("a") / "b"), c("c");
+    BOOST_TEST(a1 == a2);
+    BOOST_TEST(&a1.get() == &a2.get());
+    BOOST_TEST(a1 != c);
+    BOOST_TEST(!a1.empty());
+    BOOST_TEST(a1.get() == path("a/b"));
+    BOOST_TEST_EQ(a1->filename(), path("b"));
+
+    // Ordered by the path.
+    BOOST_TEST(a1 < c);
+    BOOST_TEST(!(c < a1));
+    BOOST_TEST(!(a1 < a2));
+    BOOST_TEST(empty < a1);
+
+    interned_path copy = c;
+    copy = a1;
+    BOOST_TEST(copy == a2);
+
+    // Paths interned after clearing the table are still equal to each
+    // other, and empty paths are kept.
+    quickbook::clear_interned_paths();
+    interned_path b1("a/b"), b2(path("a") / "b");
+    BOOST_TEST(b1 == b2);
+    BOOST_TEST(b1.get() == path("a/b"));
+    BOOST_TEST(empty == interned_path());
+    BOOST_TEST(empty == interned_path(path()));
+    BOOST_TEST(empty.empty());
+}
+
 int main()
 {
     file_path_to_url_tests();
     dir_path_to_url_tests();
     path_difference_tests();
+    lexical_path_difference_tests();
+    interned_path_tests();
     return boost::report_errors();
 }
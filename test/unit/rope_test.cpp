@@ -0,0 +1,88 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#include "rope.hpp"
+#include <boost/detail/lightweight_test.hpp>
+#include "collector.hpp"
+
+void rope_test()
+{
+    quickbook::rope empty;
+    BOOST_TEST(empty.empty());
+    BOOST_TEST(empty.begin() == empty.end());
+    BOOST_TEST_EQ(empty.str(), "");
+
+    quickbook::rope x(std::string("Hello"));
+    x.append(std::string());
+    x.append(std::string(" world"));
+    BOOST_TEST_EQ(x.size(), 11u);
+    BOOST_TEST_EQ(x.end() - x.begin(), 2);
+    BOOST_TEST_EQ(x.str(), "Hello world");
+
+    // Appending a rope shares its chunks.
+    quickbook::rope y;
+    y.append(x);
+    y.append(x);
+    BOOST_TEST_EQ(y.str(), "Hello worldHello world");
+    BOOST_TEST(y.begin()->get() == x.begin()->get());
+    BOOST_TEST_EQ(x.begin()->use_count(), 3);
+
+    std::string out = "> ";
+    y.write(out);
+    BOOST_TEST_EQ(out, "> Hello worldHello world");
+
+    y.swap(x);
+    BOOST_TEST_EQ(x.size(), 22u);
+    BOOST_TEST_EQ(y.size(), 11u);
+    y.clear();
+    BOOST_TEST(y.empty());
+}
+
+void collector_test()
+{
+    std::string large(1000, 'x');
+    quickbook::rope nested(large);
+
+    quickbook::collector out;
+    BOOST_TEST(out.empty());
+    out << "<para>" << nested << quickbook::rope(std::string("small"));
+    out << 1 << "</para>";
+    BOOST_TEST(!out.empty());
+
+    // The large chunk is only copied when the output is joined.
+    out.push();
+    out << "<entry>" << nested << "</entry>";
+    quickbook::rope entry;
+    out.swap(entry);
+    BOOST_TEST(out.empty());
+    out.pop();
+    BOOST_TEST_EQ(entry.size(), large.size() + 15);
+    BOOST_TEST_EQ(nested.begin()->use_count(), 3);
+
+    out << entry;
+    BOOST_TEST_EQ(
+        out.str(), "<para>" + large + "small1</para><entry>" + large +
+                       "</entry>");
+    BOOST_TEST_EQ(nested.begin()->use_count(), 2);
+
+    // Writing after the output has been joined.
+    out << "!";
+    std::string result;
+    out.swap(result);
+    BOOST_TEST_EQ(result.size(), 2 * large.size() + 35);
+    BOOST_TEST_EQ(result[result.size() - 1], '!');
+    BOOST_TEST(out.empty());
+}
+
+int main()
+{
+    rope_test();
+    collector_test();
+
+    return boost::report_errors();
+}
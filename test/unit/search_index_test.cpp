@@ -0,0 +1,75 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#include "search_index.hpp"
+#include <boost/detail/lightweight_test.hpp>
+
+void empty_test()
+{
+    quickbook::detail::search_index index;
+    index.add_text("Ignored, as there's no document");
+    BOOST_TEST_EQ(index.document_count(), 0u);
+    BOOST_TEST_EQ(index.term_count(), 0u);
+    BOOST_TEST_EQ(index.to_json(), "{\"documents\":[],\n\"terms\":{}}\n");
+}
+
+void terms_test()
+{
+    quickbook::detail::search_index index;
+    index.add_document("index.html", "Title");
+    index.add_text("Hello, hello World a_b x 12");
+    index.add_document("a.html#b", "\"B\"");
+    index.add_text("world");
+    index.add_document("c.html", "C");
+    index.add_document("d.html", "D");
+    index.add_text("WORLD caf\xc3\xa9");
+
+    BOOST_TEST_EQ(index.document_count(), 4u);
+    BOOST_TEST_EQ(index.term_count(), 5u);
+    BOOST_TEST_EQ(
+        index.to_json(),
+        "{\"documents\":[[\"index.html\",\"Title\"],\n"
+        "[\"a.html#b\",\"\\\"B\\\"\"],\n"
+        "[\"c.html\",\"C\"],\n"
+        "[\"d.html\",\"D\"]],\n"
+        "\"terms\":{\"12\":[0],\n"
+        "\"a_b\":[0],\n"
+        "\"caf\xc3\xa9\":[3],\n"
+        "\"hello\":[0],\n"
+        "\"world\":[0,1,2]}}\n");
+}
+
+void many_terms_test()
+{
+    // Enough terms to need several blocks of storage.
+    quickbook::detail::search_index index;
+    index.add_document("index.html", "Title");
+    std::string text;
+    for (int i = 0; i < 5000; ++i) {
+        text += "term";
+        text += std::to_string(i);
+        text += ' ';
+    }
+    index.add_text(text);
+    index.add_document("other.html", "Other");
+    index.add_text(text);
+    BOOST_TEST_EQ(index.term_count(), 5000u);
+
+    std::string json = index.to_json();
+    BOOST_TEST(json.find("\"term0\":[0,1]") != std::string::npos);
+    BOOST_TEST(json.find("\"term4999\":[0,1]") != std::string::npos);
+}
+
+int main()
+{
+    empty_test();
+    terms_test();
+    many_terms_test();
+
+    return boost::report_errors();
+}
@@ -0,0 +1,184 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#include "spill_file.hpp"
+#include <ctime>
+#include <vector>
+#include <boost/detail/lightweight_test.hpp>
+#include "collector.hpp"
+#include "document_state.hpp"
+#include "document_state_impl.hpp"
+#include "files.hpp"
+#include "grammar.hpp"
+#include "quickbook.hpp"
+#include "state.hpp"
+
+std::string read_all(quickbook::spill_file& file)
+{
+    std::string result, block;
+    file.rewind();
+    while (file.read(block)) {
+        BOOST_TEST(block.size() <= quickbook::spill_file::block_size);
+        result += block;
+    }
+    return result;
+}
+
+void spill_file_test()
+{
+    quickbook::spill_file file;
+    BOOST_TEST(file.empty());
+    BOOST_TEST_EQ(read_all(file), "");
+
+    file.write("Hello");
+    file.write(" world");
+    BOOST_TEST_EQ(file.size(), 11u);
+    BOOST_TEST_EQ(read_all(file), "Hello world");
+
+    // Can write more after reading.
+    file.write("!");
+    BOOST_TEST_EQ(read_all(file), "Hello world!");
+
+    std::string large(quickbook::spill_file::block_size + 10, 'x');
+    file.write(large);
+    BOOST_TEST_EQ(read_all(file), "Hello world!" + large);
+
+    file.clear();
+    BOOST_TEST(file.empty());
+    BOOST_TEST_EQ(read_all(file), "");
+    file.write("Again");
+    BOOST_TEST_EQ(read_all(file), "Again");
+}
+
+void string_stream_spill_test()
+{
+    quickbook::spill_file file;
+    quickbook::string_stream out;
+    out.spill_to(&file, 10);
+
+    out.get() << "<a>";
+    BOOST_TEST(file.empty());
+    out.append(std::string("0123456789"));
+    BOOST_TEST_EQ(file.size(), 13u);
+    out.get() << "<b>";
+    out.append(quickbook::rope(std::string(300, 'y')));
+    out.append(std::string("</a>"));
+    BOOST_TEST_EQ(file.size(), 316u);
+    BOOST_TEST(!out.empty());
+
+    out.get() << "tail";
+    out.spill();
+    BOOST_TEST_EQ(
+        read_all(file), "<a>0123456789<b>" + std::string(300, 'y') +
+                            "</a>tail");
+
+    // Spilled output is read back in when a string is needed.
+    out.get() << "!";
+    BOOST_TEST_EQ(
+        out.str(), "<a>0123456789<b>" + std::string(300, 'y') + "</a>tail!");
+    BOOST_TEST(file.empty());
+
+    out.clear();
+    BOOST_TEST(out.empty());
+}
+
+struct collect_ids : quickbook::xml_processor::callback
+{
+    std::vector<std::string> ids;
+    std::string parsed;
+
+    void id_value(quickbook::string_view value) { ids.push_back(value.to_s()); }
+    void finish(quickbook::string_view x) { parsed.append(x.begin(), x.end()); }
+};
+
+void partial_parse_test()
+{
+    std::string xml =
+        "<?xml version=\"1.0\"?><section id=\"$1\"><title>A</title>"
+        "<!-- <link linkend=\"$9\"> -->"
+        "<!--quickbook-escape-prefix--><a id=\"$8\"><!--quickbook-escape-"
+        "postfix--><link linkend=\"$2\" other=\"$7\">x</link>"
+        "<anchor id='$3'/></section>";
+
+    quickbook::xml_processor processor;
+    collect_ids whole;
+    processor.parse(xml, whole);
+    BOOST_TEST_EQ(whole.ids.size(), 3u);
+    BOOST_TEST_EQ(whole.parsed, xml);
+
+    // Split at every position, the ids should only be found once.
+    for (std::size_t i = 0; i <= xml.size(); ++i) {
+        collect_ids parts;
+        std::string buffer = xml.substr(0, i);
+        quickbook::string_iterator parsed =
+            processor.parse(buffer, parts, false);
+        buffer.erase(0, parsed - quickbook::string_view(buffer).begin());
+        buffer += xml.substr(i);
+        processor.parse(buffer, parts, true);
+
+        BOOST_TEST(parts.ids == whole.ids);
+        BOOST_TEST_EQ(parts.parsed, xml);
+    }
+}
+
+// Parse 'source', spilling the output to 'file' if it's set, and return
+// the unprocessed boostbook.
+std::string parse_document(
+    std::string const& source, quickbook::spill_file* file)
+{
+    quickbook::string_stream buffer;
+    quickbook::document_state ids;
+    if (file) buffer.spill_to(file, 64);
+
+    quickbook::state state("test.qbk", "", buffer, ids);
+    state.current_file = quickbook::add_file("test.qbk", source);
+    quickbook::parse_file(state);
+    BOOST_TEST_EQ(state.error_count, 0);
+    quickbook::clear_loaded_files();
+
+    if (!file) return buffer.str();
+    buffer.spill();
+    return read_all(*file);
+}
+
+// Pre-1.7 templates collect their output separately, before adding it to
+// the document, while the rest of the document stays spilled.
+void template_spill_test()
+{
+    std::string source =
+        "[article Test\n[quickbook 1.6]]\n\n"
+        "[template sect[x]\n[section:[x] Section [x]]\nText.\n[endsect]\n]\n"
+        "[template strong[x] [*[x]]]\n\n";
+    for (int i = 0; i < 50; ++i) {
+        source += "Paragraph [strong word] text.\n\n[sect s]\n\n";
+    }
+
+    tm timeinfo = tm();
+    timeinfo.tm_year = 2000 - 1900;
+    timeinfo.tm_mday = 1;
+    quickbook::current_time = &timeinfo;
+    quickbook::current_gm_time = &timeinfo;
+
+    quickbook::spill_file file;
+    std::string expected = parse_document(source, 0);
+    std::string spilled = parse_document(source, &file);
+    BOOST_TEST(
+        spilled.find("<emphasis role=\"bold\">word</emphasis>") !=
+        std::string::npos);
+    BOOST_TEST(spilled.find("<section") != std::string::npos);
+    BOOST_TEST(expected == spilled);
+}
+
+int main()
+{
+    spill_file_test();
+    string_stream_spill_test();
+    partial_parse_test();
+    template_spill_test();
+    return boost::report_errors();
+}
@@ -0,0 +1,46 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#include "string_table.hpp"
+#include <boost/detail/lightweight_test.hpp>
+
+namespace
+{
+    constexpr quickbook::detail::static_string table_[] = {
+        "a", "ab", "b", "xi:include", "\xe2\x80\x94"};
+    constexpr quickbook::detail::static_string unsorted_[] = {"b", "a"};
+    constexpr quickbook::detail::static_string duplicate_[] = {"a", "a"};
+
+    static_assert(
+        quickbook::detail::is_sorted_table(table_), "table_ isn't sorted");
+    static_assert(
+        !quickbook::detail::is_sorted_table(unsorted_), "unsorted_ is sorted");
+    static_assert(
+        !quickbook::detail::is_sorted_table(duplicate_),
+        "duplicate_ is sorted");
+
+    constexpr quickbook::detail::string_table table(table_);
+}
+
+int main()
+{
+    BOOST_TEST(table.contains("a"));
+    BOOST_TEST(table.contains("ab"));
+    BOOST_TEST(table.contains("b"));
+    BOOST_TEST(table.contains("xi:include"));
+    BOOST_TEST(table.contains("\xe2\x80\x94"));
+
+    BOOST_TEST(!table.contains(""));
+    BOOST_TEST(!table.contains("aa"));
+    BOOST_TEST(!table.contains("abc"));
+    BOOST_TEST(!table.contains("c"));
+    BOOST_TEST(!table.contains("xi"));
+    BOOST_TEST(!table.contains("\xe2\x80"));
+
+    return boost::report_errors();
+}
@@ -0,0 +1,70 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#include "svg_size.hpp"
+#include <boost/detail/lightweight_test.hpp>
+
+void basic_tests()
+{
+    quickbook::svg_size size;
+
+    BOOST_TEST(quickbook::parse_svg_size(
+        "<svg width=\"10\" height=\"20\"></svg>", size));
+    BOOST_TEST(size.has_width && size.has_height);
+    BOOST_TEST_EQ(size.width, "10");
+    BOOST_TEST_EQ(size.height, "20");
+
+    size = quickbook::svg_size();
+    BOOST_TEST(quickbook::parse_svg_size(
+        "<?xml version=\"1.0\"?>\n"
+        "<!-- <svg width=\"1\"> -->\n"
+        "<!DOCTYPE svg [ <!ENTITY x \"<svg width='2'>\"> ]>\n"
+        "<svg:svg\n"
+        "   stroke-width = \"5\"\n"
+        "   height = '7cm'\n"
+        "   width='3&amp;'/>",
+        size));
+    BOOST_TEST(size.has_width && size.has_height);
+    BOOST_TEST_EQ(size.width, "3&amp;");
+    BOOST_TEST_EQ(size.height, "7cm");
+
+    // Not an svg root element.
+    size = quickbook::svg_size();
+    BOOST_TEST(quickbook::parse_svg_size("<html width=\"1\">", size));
+    BOOST_TEST(!size.has_width && !size.has_height);
+
+    size = quickbook::svg_size();
+    BOOST_TEST(quickbook::parse_svg_size("<svg>", size));
+    BOOST_TEST(!size.has_width && !size.has_height);
+}
+
+void incomplete_tests()
+{
+    quickbook::svg_size size;
+
+    BOOST_TEST(!quickbook::parse_svg_size("", size));
+    BOOST_TEST(!quickbook::parse_svg_size("<", size));
+    BOOST_TEST(!quickbook::parse_svg_size("<!-", size));
+    BOOST_TEST(!quickbook::parse_svg_size("<?xml version=\"1.0\"", size));
+    BOOST_TEST(!quickbook::parse_svg_size("<!-- <svg> --", size));
+    BOOST_TEST(!quickbook::parse_svg_size("<!DOCTYPE svg [ > ", size));
+    BOOST_TEST(!quickbook::parse_svg_size("<sv", size));
+    BOOST_TEST(!quickbook::parse_svg_size("<svg width=\"1", size));
+    BOOST_TEST(!size.has_width);
+
+    BOOST_TEST(!quickbook::parse_svg_size("<svg width=\"1\" ", size));
+    BOOST_TEST(size.has_width && !size.has_height);
+    BOOST_TEST_EQ(size.width, "1");
+}
+
+int main()
+{
+    basic_tests();
+    incomplete_tests();
+    return boost::report_errors();
+}
@@ -0,0 +1,137 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#include "template_library.hpp"
+#include <boost/detail/lightweight_test.hpp>
+
+quickbook::template_library make_library()
+{
+    quickbook::template_library library;
+    library.qbk_version = 106;
+    library.fixed_version = true;
+    library.defines.push_back("x");
+
+    quickbook::template_library::source s;
+    s.path = "lib.qbk";
+    s.abstract_path = "sub/lib.qbk";
+    s.hash = 0x0123456789abcdefull;
+    s.qbk_version = 106;
+    // Two template bodies, originally at 3:10 and 7:3, and a macro
+    // definition from 9:6.
+    s.text = "one\ntwo\nthree[def __m__ *m*]";
+    s.sections.push_back(std::make_pair(0u, quickbook::file_position(3, 10)));
+    s.sections.push_back(std::make_pair(8u, quickbook::file_position(7, 3)));
+    s.sections.push_back(std::make_pair(18u, quickbook::file_position(9, 6)));
+    library.sources.push_back(s);
+
+    quickbook::template_library::definition d;
+    d.type = quickbook::template_library::definition::template_;
+    d.identifier = "t";
+    d.params.push_back("a");
+    d.params.push_back("b");
+    d.tag = 10;
+    d.source_index = 0;
+    d.begin = 0;
+    d.end = 8;
+    library.definitions.push_back(d);
+
+    d = quickbook::template_library::definition();
+    d.type = quickbook::template_library::definition::macro;
+    d.identifier = "__m__";
+    d.tag = quickbook::value::default_tag;
+    d.source_index = 0;
+    d.begin = 13;
+    d.end = 28;
+    library.definitions.push_back(d);
+
+    return library;
+}
+
+void round_trip_test()
+{
+    quickbook::template_library original = make_library();
+    quickbook::template_library library;
+    library.deserialize(original.serialize());
+
+    BOOST_TEST_EQ(library.qbk_version, 106u);
+    BOOST_TEST(library.fixed_version);
+    BOOST_TEST(library.defines == original.defines);
+
+    BOOST_TEST_EQ(library.sources.size(), 1u);
+    BOOST_TEST(library.sources[0].path == "lib.qbk");
+    BOOST_TEST(library.sources[0].abstract_path == "sub/lib.qbk");
+    BOOST_TEST(library.sources[0].hash == original.sources[0].hash);
+    BOOST_TEST_EQ(library.sources[0].text, original.sources[0].text);
+    BOOST_TEST_EQ(library.sources[0].sections.size(), 3u);
+
+    BOOST_TEST_EQ(library.definitions.size(), 2u);
+    BOOST_TEST_EQ(library.definitions[0].identifier, "t");
+    BOOST_TEST(library.definitions[0].params == original.definitions[0].params);
+    BOOST_TEST_EQ(library.definitions[0].tag, 10);
+    BOOST_TEST_EQ(library.definitions[0].end, 8u);
+    BOOST_TEST(
+        library.definitions[1].type ==
+        quickbook::template_library::definition::macro);
+    BOOST_TEST_EQ(library.definitions[1].identifier, "__m__");
+    BOOST_TEST_EQ(library.definitions[1].begin, 13u);
+    BOOST_TEST_EQ(library.definitions[1].end, 28u);
+}
+
+void position_test()
+{
+    quickbook::template_library library = make_library();
+    quickbook::file_ptr f = library.load_source(0);
+    quickbook::string_iterator begin = f->source().begin();
+
+    BOOST_TEST_EQ(f->version(), 106u);
+    BOOST_TEST_EQ(f->position_of(begin), quickbook::file_position(3, 10));
+    BOOST_TEST_EQ(f->position_of(begin + 2), quickbook::file_position(3, 12));
+    BOOST_TEST_EQ(f->position_of(begin + 5), quickbook::file_position(4, 2));
+    BOOST_TEST_EQ(f->position_of(begin + 8), quickbook::file_position(7, 3));
+    BOOST_TEST_EQ(f->position_of(begin + 9), quickbook::file_position(7, 4));
+    BOOST_TEST_EQ(f->position_of(begin + 18), quickbook::file_position(9, 6));
+}
+
+void invalid_test()
+{
+    std::string data = make_library().serialize();
+    quickbook::template_library library;
+
+    BOOST_TEST_THROWS(
+        library.deserialize("not a library"),
+        quickbook::template_library_error);
+    BOOST_TEST_THROWS(
+        library.deserialize(
+            quickbook::string_view(data.data(), data.size() - 1)),
+        quickbook::template_library_error);
+    BOOST_TEST_THROWS(
+        library.deserialize(data + "x"), quickbook::template_library_error);
+
+    // A template outside of the source text.
+    quickbook::template_library bad = make_library();
+    bad.definitions[0].end = 100;
+    BOOST_TEST_THROWS(
+        library.deserialize(bad.serialize()),
+        quickbook::template_library_error);
+
+    // A macro from a source that doesn't exist.
+    bad = make_library();
+    bad.definitions[1].source_index = 1;
+    BOOST_TEST_THROWS(
+        library.deserialize(bad.serialize()),
+        quickbook::template_library_error);
+}
+
+int main()
+{
+    round_trip_test();
+    position_test();
+    invalid_test();
+
+    return boost::report_errors();
+}
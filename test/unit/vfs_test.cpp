@@ -0,0 +1,224 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#include "vfs.hpp"
+#include <boost/detail/lightweight_test.hpp>
+#include "svg_size.hpp"
+
+bool has_entry(
+    std::vector<quickbook::file_system::entry> const& entries,
+    char const* name,
+    bool is_directory)
+{
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].name == name) {
+            return entries[i].is_directory == is_directory &&
+                   entries[i].is_regular_file == !is_directory;
+        }
+    }
+    return false;
+}
+
+void memory_file_system_test()
+{
+    quickbook::memory_file_system files;
+    files.add_file("doc/a.qbk", "Hello");
+    files.add_file("doc/sub/b.qbk", "World");
+
+    quickbook::file_status s = files.status("doc/a.qbk");
+    BOOST_TEST(s.exists);
+    BOOST_TEST(!s.is_directory);
+    BOOST_TEST_EQ(s.size, 5u);
+
+    s = files.status("doc/sub");
+    BOOST_TEST(s.exists);
+    BOOST_TEST(s.is_directory);
+    BOOST_TEST(!files.status("doc/missing.qbk").exists);
+
+    // Paths are compared after removing '.' and '..'.
+    std::string contents;
+    BOOST_TEST(files.read("doc/./sub/../a.qbk", contents));
+    BOOST_TEST_EQ(contents, "Hello");
+    BOOST_TEST(files.read("doc/sub/b.qbk", contents, 3));
+    BOOST_TEST_EQ(contents, "Wor");
+    BOOST_TEST(!files.read("doc/sub", contents));
+
+    std::vector<quickbook::file_system::entry> entries;
+    BOOST_TEST(files.list("doc", entries));
+    BOOST_TEST_EQ(entries.size(), 2u);
+    BOOST_TEST(has_entry(entries, "a.qbk", false));
+    BOOST_TEST(has_entry(entries, "sub", true));
+
+    entries.clear();
+    BOOST_TEST(files.list(".", entries));
+    BOOST_TEST_EQ(entries.size(), 1u);
+    BOOST_TEST(has_entry(entries, "doc", true));
+    BOOST_TEST(!files.list("doc/a.qbk", entries));
+
+    BOOST_TEST(files.create_directories("out/html"));
+    BOOST_TEST(files.status("out/html").is_directory);
+    BOOST_TEST(files.write("out/html/index.html", "<html>"));
+    BOOST_TEST(files.get_file("out/html/index.html", contents));
+    BOOST_TEST_EQ(contents, "<html>");
+    BOOST_TEST(files.append("out/html/index.html", "</html>"));
+    BOOST_TEST(files.append("out/new.xml", "<a/>"));
+    BOOST_TEST(files.get_file("out/html/index.html", contents));
+    BOOST_TEST_EQ(contents, "<html></html>");
+    BOOST_TEST(files.get_file("out/new.xml", contents));
+    BOOST_TEST_EQ(contents, "<a/>");
+}
+
+void caching_file_system_test()
+{
+    quickbook::memory_file_system base;
+    base.add_file("a.txt", "0123456789");
+    quickbook::caching_file_system files(base);
+
+    std::string contents;
+    BOOST_TEST(files.read("a.txt", contents, 4));
+    BOOST_TEST_EQ(contents, "0123");
+    BOOST_TEST(files.read("a.txt", contents, 2));
+    BOOST_TEST_EQ(contents, "01");
+    BOOST_TEST_EQ(files.get_statistics().reads, 1u);
+
+    // Only the start was cached, so this has to read the whole file.
+    BOOST_TEST(files.read("a.txt", contents));
+    BOOST_TEST_EQ(contents, "0123456789");
+    BOOST_TEST(files.read("a.txt", contents));
+    BOOST_TEST_EQ(files.get_statistics().reads, 2u);
+    BOOST_TEST_EQ(files.get_statistics().bytes_read, 14u);
+
+    BOOST_TEST(!files.status("b.txt").exists);
+    BOOST_TEST(!files.status("b.txt").exists);
+    BOOST_TEST(!files.read("b.txt", contents));
+    BOOST_TEST(!files.read("b.txt", contents));
+    BOOST_TEST_EQ(files.get_statistics().status, 1u);
+    BOOST_TEST_EQ(files.get_statistics().reads, 3u);
+
+    std::vector<quickbook::file_system::entry> entries;
+    BOOST_TEST(files.list(".", entries));
+    BOOST_TEST_EQ(entries.size(), 1u);
+
+    // Writing replaces the cached contents and listing.
+    BOOST_TEST(files.write("b.txt", "new"));
+    BOOST_TEST(files.status("b.txt").exists);
+    BOOST_TEST(files.read("b.txt", contents));
+    BOOST_TEST_EQ(contents, "new");
+    entries.clear();
+    BOOST_TEST(files.list(".", entries));
+    BOOST_TEST_EQ(entries.size(), 2u);
+
+    quickbook::caching_file_system::statistics stats =
+        files.get_statistics();
+    BOOST_TEST_EQ(stats.status, 2u);
+    BOOST_TEST_EQ(stats.reads, 4u);
+    BOOST_TEST_EQ(stats.lists, 2u);
+    BOOST_TEST_EQ(stats.writes, 1u);
+    BOOST_TEST_EQ(stats.bytes_written, 3u);
+}
+
+void update_file_test()
+{
+    quickbook::memory_file_system base;
+    quickbook::caching_file_system files(base);
+
+    BOOST_TEST(
+        quickbook::update_file(files, "out/a.html", "one") ==
+        quickbook::file_written);
+    BOOST_TEST(
+        quickbook::update_file(files, "out/a.html", "one") ==
+        quickbook::file_unchanged);
+    BOOST_TEST(
+        quickbook::update_file(files, "out/a.html", "two") ==
+        quickbook::file_written);
+    BOOST_TEST(
+        quickbook::update_file(files, "out/a.html", "three") ==
+        quickbook::file_written);
+
+    std::string contents;
+    BOOST_TEST(base.get_file("out/a.html", contents));
+    BOOST_TEST_EQ(contents, "three");
+    BOOST_TEST_EQ(files.get_statistics().writes, 3u);
+
+    // The temporary files are renamed.
+    std::vector<quickbook::file_system::entry> entries;
+    BOOST_TEST(files.list("out", entries));
+    BOOST_TEST_EQ(entries.size(), 1u);
+
+    BOOST_TEST(files.remove("out/a.html"));
+    BOOST_TEST(!files.status("out/a.html").exists);
+    BOOST_TEST(!files.remove("out/a.html"));
+}
+
+void current_file_system_test()
+{
+    quickbook::file_system& native = quickbook::native_file_system();
+    BOOST_TEST(&quickbook::get_file_system() == &native);
+
+    quickbook::memory_file_system files;
+    files.add_file("images/small.svg", "<svg width=\"1\" height=\"2\">");
+    files.add_file(
+        "images/large.svg", std::string(5000, ' ') + "<svg width=\"3\">");
+
+    BOOST_TEST(quickbook::set_file_system(&files) == &native);
+    BOOST_TEST(&quickbook::get_file_system() == &files);
+
+    quickbook::svg_size size = quickbook::read_svg_size("images/small.svg");
+    BOOST_TEST_EQ(size.width, "1");
+    BOOST_TEST_EQ(size.height, "2");
+
+    // The start tag isn't in the first block.
+    size = quickbook::read_svg_size("images/large.svg");
+    BOOST_TEST(size.has_width);
+    BOOST_TEST_EQ(size.width, "3");
+    BOOST_TEST(!size.has_height);
+
+    BOOST_TEST(!quickbook::read_svg_size("images/missing.svg").has_width);
+
+    BOOST_TEST(quickbook::set_file_system(0) == &files);
+    BOOST_TEST(&quickbook::get_file_system() == &native);
+}
+
+// Only the start of a large svg file is read.
+void svg_read_size_test()
+{
+    quickbook::memory_file_system files;
+    files.add_file(
+        "images/comment.svg", "<!--" + std::string(20000, ' ') +
+                                  "--><svg width=\"4\">" +
+                                  std::string(1000000, ' ') + "</svg>");
+    files.add_file(
+        "images/too_large.svg", "<!--" + std::string(2000000, ' ') +
+                                    "--><svg width=\"5\"></svg>");
+
+    quickbook::caching_file_system caching(files);
+    quickbook::set_file_system(&caching);
+
+    quickbook::svg_size size = quickbook::read_svg_size("images/comment.svg");
+    BOOST_TEST_EQ(size.width, "4");
+    BOOST_TEST(caching.get_statistics().bytes_read < 100000u);
+
+    // Gives up after 256KB, rather than reading the whole file.
+    boost::uintmax_t bytes_read = caching.get_statistics().bytes_read;
+    size = quickbook::read_svg_size("images/too_large.svg");
+    BOOST_TEST(!size.has_width);
+    BOOST_TEST(caching.get_statistics().bytes_read - bytes_read < 400000u);
+
+    quickbook::set_file_system(0);
+}
+
+int main()
+{
+    memory_file_system_test();
+    caching_file_system_test();
+    update_file_test();
+    current_file_system_test();
+    svg_read_size_test();
+
+    return boost::report_errors();
+}
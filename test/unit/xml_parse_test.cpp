@@ -0,0 +1,107 @@
+/*=============================================================================
+    Copyright (c) 2026 agent
+
+    Use, modification and distribution is subject to the Boost Software
+    License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+    http://www.boost.org/LICENSE_1_0.txt)
+=============================================================================*/
+
+#include "xml_parse.hpp"
+#include <boost/detail/lightweight_test.hpp>
+
+using quickbook::detail::xml_arena;
+using quickbook::detail::xml_element;
+using quickbook::detail::xml_parse;
+using quickbook::detail::xml_tree;
+
+void parse_test()
+{
+    std::string source =
+        "<?xml version=\"1.0\"?>\n"
+        "<!DOCTYPE section>\n"
+        "<section id=\"a&amp;b\" role='x' role=\"y\">"
+        "<title>T &lt; U</title>"
+        "<!--quickbook-escape-prefix--><b>-- - -></b>"
+        "<!--quickbook-escape-postfix-->"
+        "<link linkend=\"a\"/></section>";
+
+    xml_arena arena;
+    xml_tree tree = xml_parse(arena, source);
+
+    // The prolog is just whitespace.
+    xml_element* text = tree.root();
+    BOOST_TEST(text && text->type_ == xml_element::element_text);
+    BOOST_TEST_EQ(text->contents_, "\n");
+
+    xml_element* section = text->next()->next();
+    BOOST_TEST(section && section->type_ == xml_element::element_node);
+    BOOST_TEST_EQ(section->name_, "section");
+    BOOST_TEST_EQ(section->get_attribute("id"), "a&b");
+    BOOST_TEST_EQ(section->get_attribute("role"), "y");
+    BOOST_TEST(!section->has_attribute("linkend"));
+
+    // Text is still encoded, and points into the source.
+    xml_element* title = section->get_child("title");
+    BOOST_TEST(title && title->children());
+    BOOST_TEST_EQ(title->children()->contents_, "T &lt; U");
+    BOOST_TEST(
+        title->children()->contents_.data() >= source.data() &&
+        title->children()->contents_.data() < source.data() + source.size());
+
+    // Escaped markup is parsed as normal.
+    xml_element* b = section->get_child("b");
+    BOOST_TEST(b && b->children());
+    BOOST_TEST_EQ(b->children()->contents_, "-- - ->");
+
+    xml_element* link = section->get_child("link");
+    BOOST_TEST(link && !link->children());
+    BOOST_TEST_EQ(link->get_attribute("linkend"), "a");
+
+    BOOST_TEST_EQ(section->set_attribute("id", "new"), "new");
+    BOOST_TEST_EQ(section->get_attribute("id"), "new");
+    section->set_attribute("class", std::string("c"));
+    BOOST_TEST_EQ(section->get_attribute("class"), "c");
+
+    xml_element* html = xml_element::html_node(arena, std::string("<p>"));
+    BOOST_TEST_EQ(html->contents_, "<p>");
+    title->children()->add_before(xml_tree(html));
+    BOOST_TEST(title->children() == html);
+}
+
+void parse_error_test()
+{
+    char const* invalid[] = {"</a>",    "<a></b>", "<a b='c>", "<!-- x",
+                             "<a b=c>", "<",       "<a/ x>",   "<?x y ?"};
+
+    for (std::size_t i = 0; i < sizeof(invalid) / sizeof(*invalid); ++i) {
+        xml_arena arena;
+        bool failed = false;
+        try {
+            xml_parse(arena, invalid[i]);
+        } catch (quickbook::detail::xml_parse_error&) {
+            failed = true;
+        }
+        BOOST_TEST(failed);
+    }
+}
+
+void arena_test()
+{
+    xml_arena arena;
+    std::string large(100000, 'x');
+    quickbook::string_view x = arena.store("Hello");
+    quickbook::string_view y = arena.store(large);
+    quickbook::string_view z = arena.store("World");
+    BOOST_TEST_EQ(x, "Hello");
+    BOOST_TEST_EQ(y, large);
+    BOOST_TEST_EQ(z, "World");
+    BOOST_TEST(arena.store("").empty());
+}
+
+int main()
+{
+    parse_test();
+    parse_error_test();
+    arena_test();
+    return boost::report_errors();
+}